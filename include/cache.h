@@ -0,0 +1,56 @@
+// cache.h
+#ifndef BC_SPLITTER_CACHE_H
+#define BC_SPLITTER_CACHE_H
+
+#include "callgraph.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 缓存键：输入内容、符号表、分析方式和提取规则都一致时缓存才有效
+struct AnalysisCacheKey {
+    uint64_t inputHash = 0;
+    // 按符号ID顺序的符号名哈希，保证缓存中的ID与本次的编号一致
+    uint64_t symbolHash = 0;
+    uint32_t symbolCount = 0;
+    uint32_t engine = 0;
+    // 工具的调用边提取规则版本，新版本的工具不会读到旧规则得到的边
+    uint32_t rulesVersion = 0;
+};
+
+// 缓存的分析结果，边以符号ID表示
+struct AnalysisSnapshot {
+    std::vector<CallGraph::Edge> callEdges;
+    std::vector<CallGraph::Edge> personalityEdges;
+    std::vector<uint32_t> instructionCounts;
+};
+
+/**
+ * @brief 以输入bitcode内容哈希为键的调用关系分析缓存
+ *
+ * 每个输入一个文件：定长文件头（魔数、格式版本、LLVM主版本和缓存键）之后依次是
+ * 调用边、personality边和每个符号的指令数，均为本机字节序的uint32数组，
+ * 读取时直接映射文件。写入经AsyncFileWriter::writeAtomically，不会留下半个文件。
+ * SCC由加载后的调用图线性时间重建，不单独缓存。
+ */
+class AnalysisCache {
+  public:
+    explicit AnalysisCache(std::string directory) : directory(std::move(directory)) {}
+
+    std::string getPath(const AnalysisCacheKey &key) const;
+
+    // 文件不存在或键不匹配时返回false，error给出原因
+    bool load(const AnalysisCacheKey &key, AnalysisSnapshot &snapshot, std::string &error) const;
+    bool store(const AnalysisCacheKey &key, const AnalysisSnapshot &snapshot, std::string &error) const;
+
+    static uint64_t hashContents(llvm::StringRef contents);
+    // 符号名以'\0'分隔后的哈希
+    static uint64_t hashNames(llvm::ArrayRef<llvm::StringRef> names);
+
+  private:
+    std::string directory;
+};
+
+#endif // BC_SPLITTER_CACHE_H
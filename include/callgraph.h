@@ -0,0 +1,137 @@
+// callgraph.h
+#ifndef BC_SPLITTER_CALLGRAPH_H
+#define BC_SPLITTER_CALLGRAPH_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/BitVector.h"
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// 稠密符号ID，由BCCommon::assignSymbolIds按模块顺序分配
+using SymbolId = uint32_t;
+constexpr SymbolId InvalidSymbolId = UINT32_MAX;
+
+/**
+ * @brief 冻结的压缩稀疏行（CSR）调用图
+ *
+ * 正向（被调用者）和反向（调用者）邻接各用一个偏移数组加一个目标数组保存，
+ * 每一行按符号ID升序且无重复。构建完成后只读，可被多个线程同时访问。
+ */
+class CallGraph {
+  public:
+    // 边 (调用者, 被调用者)
+    using Edge = std::pair<SymbolId, SymbolId>;
+
+    CallGraph() = default;
+
+    // 由边列表构建图，edges会被排序去重
+    void build(size_t symbolCount, std::vector<Edge> &edges);
+    void clear();
+
+    size_t getSymbolCount() const { return forwardOffsets.empty() ? 0 : forwardOffsets.size() - 1; }
+    size_t getEdgeCount() const { return forwardTargets.size(); }
+
+    // 被调用者列表
+    llvm::ArrayRef<SymbolId> calleds(SymbolId id) const {
+        return llvm::ArrayRef<SymbolId>(forwardTargets).slice(forwardOffsets[id], outDegree(id));
+    }
+    // 调用者列表
+    llvm::ArrayRef<SymbolId> callers(SymbolId id) const {
+        return llvm::ArrayRef<SymbolId>(reverseTargets).slice(reverseOffsets[id], inDegree(id));
+    }
+
+    unsigned outDegree(SymbolId id) const { return forwardOffsets[id + 1] - forwardOffsets[id]; }
+    unsigned inDegree(SymbolId id) const { return reverseOffsets[id + 1] - reverseOffsets[id]; }
+
+  private:
+    std::vector<uint32_t> forwardOffsets;
+    std::vector<SymbolId> forwardTargets;
+    std::vector<uint32_t> reverseOffsets;
+    std::vector<SymbolId> reverseTargets;
+};
+
+/**
+ * @brief 调用图的强连通分量分解及其缩点DAG
+ *
+ * 使用非递归Tarjan算法，每个符号记录一个SCC编号，SCC成员连续存放。
+ * SCC按Tarjan完成顺序编号，缩点DAG中的边总是从大编号指向小编号：
+ * 编号升序即逆拓扑序（被调用者在前），降序即拓扑序（调用者在前）。
+ */
+class SCCGraph {
+  public:
+    SCCGraph() = default;
+
+    void build(const CallGraph &callGraph);
+    void clear();
+
+    size_t getSCCCount() const { return sccOffsets.empty() ? 0 : sccOffsets.size() - 1; }
+    uint32_t getSCC(SymbolId id) const { return sccOf[id]; }
+
+    // SCC的成员列表
+    llvm::ArrayRef<SymbolId> members(uint32_t scc) const {
+        return llvm::ArrayRef<SymbolId>(sccMembers).slice(sccOffsets[scc], sccOffsets[scc + 1] - sccOffsets[scc]);
+    }
+    // 成员数大于1的SCC即循环调用组
+    bool isCyclic(uint32_t scc) const { return sccOffsets[scc + 1] - sccOffsets[scc] > 1; }
+
+    // 缩点DAG，节点为SCC编号
+    const CallGraph &getCondensation() const { return condensation; }
+
+    // 标签传播结果：没有任何种子到达
+    static constexpr int NoLabel = 0;
+    // 标签传播结果：被两个及以上不同标签到达
+    static constexpr int ConflictLabel = -1;
+
+    /**
+     * @brief 沿调用方向把种子标签传播到所有可达符号
+     *
+     * seedLabels以符号ID为下标，正数为种子标签，NoLabel表示不是种子。
+     * 结果中每个符号的值为：唯一到达它的标签；多个不同标签到达时为ConflictLabel；
+     * 没有种子到达时为NoLabel。按拓扑序在缩点DAG上做一次 O(V+E) 的遍历。
+     */
+    std::vector<int> propagateUniqueLabels(llvm::ArrayRef<int> seedLabels) const;
+
+  private:
+    std::vector<uint32_t> sccOf;
+    std::vector<uint32_t> sccOffsets;
+    std::vector<SymbolId> sccMembers;
+    CallGraph condensation;
+};
+
+/**
+ * @brief 符号分组表
+ *
+ * groupOf以符号ID为下标记录分组号；各组成员按组号连续存放，组内按符号ID升序。
+ * exported标记存在组外调用者的符号，拆分后的模块中这些符号需要对外可见。
+ */
+class GroupTable {
+  public:
+    GroupTable() = default;
+
+    // 由每个符号的分组号构建成员表，并在调用图上一次扫描得到exported位图
+    void build(std::vector<int> groupOfSymbol, size_t groupCount, const CallGraph &callGraph);
+    void clear();
+
+    size_t getGroupCount() const { return memberOffsets.empty() ? 0 : memberOffsets.size() - 1; }
+    size_t getSymbolCount() const { return groupOf.size(); }
+    int getGroup(SymbolId id) const { return groupOf[id]; }
+
+    // 组成员列表
+    llvm::ArrayRef<SymbolId> members(size_t group) const {
+        return llvm::ArrayRef<SymbolId>(groupMembers)
+            .slice(memberOffsets[group], memberOffsets[group + 1] - memberOffsets[group]);
+    }
+
+    // 符号是否被其他组调用
+    bool isExported(SymbolId id) const { return exported.test(id); }
+    size_t getExportedCount() const { return exported.count(); }
+
+  private:
+    std::vector<int> groupOf;
+    std::vector<uint32_t> memberOffsets;
+    std::vector<SymbolId> groupMembers;
+    llvm::BitVector exported;
+};
+
+#endif // BC_SPLITTER_CALLGRAPH_H
@@ -1,8 +1,11 @@
 #ifndef BC_SPLITTER_COMMON_H
 #define BC_SPLITTER_COMMON_H
 
+#include "cache.h"
+#include "callgraph.h"
 #include "core.h"
 #include "logging.h"
+#include "stringmatch.h"
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/SetVector.h"
 #include "llvm/ADT/SmallVector.h"
@@ -19,14 +22,34 @@
 #include "llvm/IR/Verifier.h"
 #include "llvm/IRReader/IRReader.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/raw_ostream.h"
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <set>
 #include <string>
 #include <unordered_map>
 
+// 调用关系分析引擎
+enum class CallGraphEngine {
+    // 逐条扫描函数体指令
+    IR,
+    // 读取ModuleSummaryIndex中的调用和引用列表
+    Summary
+};
+
+// 分组模块的优化在拆分器与ld.lld链接时LTO之间的分工
+enum class OptimizationPlacement {
+    // 拆分器运行完整O2（FullLTOPostLink），链接时LTO再优化一次
+    Both,
+    // 拆分器只运行LTO预链接管道，主要优化留给链接时LTO
+    Linker,
+    // 拆分器运行完整O2，链接时LTO不再做IR优化，只做代码生成
+    Splitter
+};
+
 // 配置结构体
 struct Config {
     const std::string workDir = "/Users/wangzirui/Desktop/libkn_so/reproduce_kn_shared_20251119_094034/";
@@ -37,6 +60,45 @@ struct Config {
         "/Users/wangzirui/Desktop/libkn_so/reproduce_kn_shared_20251119_094034/response.txt";
     const std::string workSpace = "/Users/wangzirui/Desktop/libkn_so/test/workspace/";
 
+    // 调试选项：将就地重命名后的模块写出为 output/renamed_<输入>.bc
+    bool dumpRenamedBitcode = false;
+    // 以mmap方式惰性加载输入bitcode，分析阶段按需物化函数体
+    bool lazyLoadInput = true;
+    // 加载IR之前只读bitcode符号表，按包名给出预分组和各包规模
+    bool symbolTablePrepass = true;
+    // 调用关系分析引擎；Summary在输入嵌入了模块摘要时不需要物化函数体，
+    // 惰性加载的输入没有摘要时退回分批的IR分析，完整加载的输入现场构建摘要
+    CallGraphEngine callGraphEngine = CallGraphEngine::IR;
+    // 调试选项：摘要分析时同时运行IR分析，把两者边的差异写入日志
+    bool crossCheckCallGraph = false;
+    // 以输入内容哈希为键缓存调用关系分析结果（workspace/cache/），输入不变时跳过分析
+    bool analysisCache = true;
+    // 调用关系分析的线程数，0表示使用硬件并发数
+    unsigned analysisThreads = 0;
+    // Clone模式下按组选择性抽取符号；关闭时退回对整个模块CloneModule后删除函数体
+    bool selectiveExtraction = true;
+    // 优化放置：每个分组的bitcode只由自己的ld.lld链接，拆分器的O2与链接时LTO看到的范围相同，
+    // 两边都做完整优化是重复的
+    OptimizationPlacement optimizationPlacement = OptimizationPlacement::Linker;
+    // Splitter放置时追加到ld.lld的参数：关闭LTO的IR优化，代码生成保持O2（--lto-CGO需要lld 16及以上）
+    const std::string splitterPlacementLinkerFlags = "--lto-O0 --lto-CGO2";
+    // 分组优化方案配置文件（格式见profile.h），不存在时所有分组使用O2
+    const std::string optimizationProfileFile = workSpace + "config/optimization_profiles.conf";
+    // 记录每组每个Pass的墙钟和CPU耗时及指令数变化，写出 logs/<前缀>_optimization_report.json
+    bool passTimingReport = true;
+    // 优化后压缩分组模块：删除无引用的声明、空comdat和无效调试信息，丢弃局部值名字
+    bool compactGroupModules = true;
+    // 分组BC文件的生成线程数，0表示使用硬件并发数，1表示在主上下文中串行生成；
+    // 并行生成要求输入为惰性加载的bitcode，每个线程在自己的LLVMContext中重新加载
+    unsigned emissionThreads = 0;
+    // 调试选项：生成后从磁盘重新解析每个输出文件做验证和统计，默认使用写出前在内存中采集的记录
+    bool paranoidReparse = false;
+    // 并行生成的内存预算（MB），按预测占用做准入控制；0表示物理内存的3/4
+    size_t emissionMemoryBudgetMB = 0;
+    // 分组BC文件序列化到内存后交给后台线程写盘，与下一组的抽取和优化重叠；
+    // 该值为排队缓冲区的上限（MB），0表示在生成线程中同步写出
+    size_t asyncWriteQueueMB = 256;
+
     // 存储字符串集合
     llvm::SmallVector<std::string, 32> packageStrings;
 
@@ -164,12 +226,52 @@ struct GroupInfo {
     void printDetails() const;
 };
 
+/**
+ * @brief 一个分组BC文件的生成记录
+ *
+ * 在模块写出之前、仍在内存中时采集。之后的批量验证、分组报告和链接阶段直接使用，
+ * 不再从磁盘重新解析输出文件（Config::paranoidReparse 打开时除外）。
+ */
+struct EmissionRecord {
+    int fileIndex = -1;
+    std::string filename;
+    // 文件已成功写出；异步写出时由写盘线程设置，写盘队列排空之前不要读取
+    bool written = false;
+    // 序列化后的bitcode字节数
+    size_t bitcodeBytes = 0;
+    // 该组使用的优化方案，以及ld.lld链接该组时追加的LTO参数
+    std::string optimizationProfile;
+    std::string linkerFlags;
+    // verifyModule的结果和错误信息
+    bool moduleValid = false;
+    std::string verifyErrors;
+    // 模块中的定义（有初始值的全局变量、有函数体的函数）的简略信息，按模块顺序
+    std::vector<std::string> symbolBriefs;
+    AttributeStats globalVariableStats;
+    AttributeStats functionStats;
+    bool hasKonanCxaDemangle = false;
+    // 依赖的其他分组文件序号
+    llvm::SmallSetVector<int, 32> dependencies;
+};
+
+/**
+ * @brief 基于Aho–Corasick自动机的符号名子串匹配器
+ *
+ * rebuildCache一次性构建不可变索引，之后以原子方式发布；查询只读取当前索引的快照，
+ * 不加锁，可与重建并发进行。一次查询的代价为 O(|str| + 匹配数)。
+ */
 class GlobalValueNameMatcher {
   private:
-    // 缓存函数名列表
-    llvm::StringMap<llvm::GlobalValue *> nameCache;
-    std::mutex cacheMutex;
-    bool cacheValid = false;
+    // 不可变的名字索引：模式编号即names/values的下标
+    struct NameIndex {
+        AhoCorasickMatcher automaton;
+        std::vector<std::string> names;
+        std::vector<llvm::GlobalValue *> values;
+    };
+    // 通过std::atomic_load/atomic_store访问
+    std::shared_ptr<const NameIndex> index;
+
+    std::shared_ptr<const NameIndex> snapshot() const { return std::atomic_load(&index); }
 
   public:
     GlobalValueNameMatcher() = default;
@@ -182,31 +284,61 @@ class GlobalValueNameMatcher {
     void invalidateCache();
 
     // 检查缓存是否有效
-    bool isCacheValid() const { return cacheValid; }
+    bool isCacheValid() const { return snapshot() != nullptr; }
 
     // 获取缓存大小
-    size_t getCacheSize() const { return nameCache.size(); }
+    size_t getCacheSize() const;
 
     // 检查字符串是否包含任何函数名
-    bool containsGlobalValueName(llvm::StringRef str);
+    bool containsGlobalValueName(llvm::StringRef str) const;
 
     // 获取匹配的所有函数信息
-    llvm::StringMap<llvm::GlobalValue *> getMatchingGlobalValues(llvm::StringRef str);
+    llvm::StringMap<llvm::GlobalValue *> getMatchingGlobalValues(llvm::StringRef str) const;
+
+    // 获取字符串中最先出现（结束位置最靠前）的函数，无匹配时返回nullptr
+    llvm::GlobalValue *getFirstMatchingGlobalValue(llvm::StringRef str) const;
 };
 
 class BCCommon {
+  public:
+    // 调用边列表 (调用者ID, 被调用者ID)
+    using CallEdgeList = std::vector<CallGraph::Edge>;
+    // 常量 -> 引用的符号ID列表（有序去重）
+    using ConstantRefMemo = llvm::DenseMap<const llvm::Constant *, std::vector<SymbolId>>;
+    // 常量链上的User -> 所属全局对象
+    using ConstantOwnerMemo = llvm::DenseMap<const llvm::User *, llvm::GlobalValue *>;
+    // 调用边收集时每个线程私有的缓存
+    struct CallEdgeScratch {
+        ConstantRefMemo constantRefs;
+        ConstantOwnerMemo constantOwners;
+    };
+
   private:
+    // 输入文件的只读映射，惰性模块在其生命周期内从中读取函数体
+    std::unique_ptr<llvm::MemoryBuffer> inputBuffer;
+    // 输入文件内容的哈希，作为分析缓存的键；0表示不使用缓存
+    uint64_t inputHash = 0;
     std::unique_ptr<llvm::Module> module;
     llvm::DenseMap<llvm::GlobalValue *, GlobalValueInfo> globalValueMap;
+    // 符号ID到全局对象/符号信息的映射，assignSymbolIds之后globalValueMap不再增删
+    std::vector<llvm::GlobalValue *> symbols;
+    std::vector<GlobalValueInfo *> symbolInfos;
+    // 全局变量初始值的常量引用，分析期间只读共享
+    ConstantRefMemo initializerRefMemo;
+    // 每个符号的指令数（全局变量为0），调用关系分析时统计，用于预测分组的内存占用
+    std::vector<uint32_t> instructionCounts;
+    // 调用关系和personality关系的CSR图
+    CallGraph callGraph;
+    CallGraph personalityGraph;
     llvm::SmallVector<GroupInfo *, 32> fileMap;
-    // 符号组
-    llvm::SmallVector<llvm::DenseSet<llvm::GlobalValue *>, 32> globalValuesAllGroups;
+    // 每个输出文件的生成记录，以文件序号为下标
+    std::vector<EmissionRecord> emissionRecords;
+    // 符号分组表：分组号数组、按组连续的成员表和exported位图
+    GroupTable groupTable;
     llvm::LLVMContext *context;
     Config config;
-    // 存储循环调用组
-    llvm::SmallVector<llvm::DenseSet<llvm::GlobalValue *>, 32> cyclicGroups;
-    // 函数到所属循环组的映射（一个函数可能属于多个组）
-    llvm::DenseMap<llvm::GlobalValue *, llvm::SmallVector<int, 32>> globalValueToGroupMap;
+    // 调用图的强连通分量，成员数大于1的分量即循环调用组
+    SCCGraph sccGraph;
     Logger logger;
     GlobalValueNameMatcher GlobalValueNameMatcher;
 
@@ -220,33 +352,51 @@ class BCCommon {
     const llvm::SmallVector<GroupInfo *, 32> &getFileMap() const { return fileMap; }
     llvm::DenseMap<llvm::GlobalValue *, GlobalValueInfo> &getGlobalValueMap() { return globalValueMap; }
     const llvm::DenseMap<llvm::GlobalValue *, GlobalValueInfo> &getGlobalValueMap() const { return globalValueMap; }
-    llvm::SmallVector<llvm::DenseSet<llvm::GlobalValue *>, 32> &getGlobalValuesAllGroups() {
-        return globalValuesAllGroups;
-    }
-    const llvm::SmallVector<llvm::DenseSet<llvm::GlobalValue *>, 32> &getGlobalValuesAllGroups() const {
-        return globalValuesAllGroups;
-    }
+    const GroupTable &getGroupTable() const { return groupTable; }
+    std::vector<EmissionRecord> &getEmissionRecords() { return emissionRecords; }
+    const std::vector<EmissionRecord> &getEmissionRecords() const { return emissionRecords; }
     llvm::LLVMContext *getContext() const { return context; }
+    const CallGraph &getCallGraph() const { return callGraph; }
+    const CallGraph &getPersonalityGraph() const { return personalityGraph; }
+    const SCCGraph &getSCCGraph() const { return sccGraph; }
+    llvm::ArrayRef<llvm::GlobalValue *> getSymbols() const { return symbols; }
+    llvm::ArrayRef<GlobalValueInfo *> getSymbolInfos() const { return symbolInfos; }
+    SymbolId getSymbolId(const llvm::GlobalValue *GV) const;
 
     // 设置器
     void setModule(std::unique_ptr<llvm::Module> M) { module = std::move(M); }
     void setContext(llvm::LLVMContext *newContext) { context = newContext; }
+    void setInputBuffer(std::unique_ptr<llvm::MemoryBuffer> buffer) { inputBuffer = std::move(buffer); }
+    void setInputHash(uint64_t hash) { inputHash = hash; }
 
     // 辅助方法
     bool hasModule() const { return module != nullptr; }
+    const llvm::MemoryBuffer *getInputBuffer() const { return inputBuffer.get(); }
     size_t getGlobalValueCount() const { return globalValueMap.size(); }
     bool writeBitcodeSafely(llvm::Module &M, llvm::StringRef filename);
-    std::string renameUnnamedGlobalValues(llvm::StringRef filename);
+    bool writeBitcodeSafely(llvm::ArrayRef<char> bitcode, llvm::StringRef filename);
+    static void serializeBitcode(llvm::Module &M, llvm::SmallVectorImpl<char> &buffer);
+    static void captureModuleSummary(llvm::Module &M, EmissionRecord &record);
+    bool reparseEmissionRecord(EmissionRecord &record);
+    AnalysisCacheKey makeAnalysisCacheKey() const;
+    static unsigned renameUnnamedGlobalValues(llvm::Module &M);
     static bool matchesPattern(llvm::StringRef filename, llvm::StringRef pattern);
     bool copyByPattern(llvm::StringRef pattern);
     static bool isNumberString(llvm::StringRef str);
-    static llvm::SmallVector<int, 32>
-    convertIndexToFiltered(const llvm::SmallVector<llvm::DenseSet<llvm::GlobalValue *>, 32> &globalValuesAllGroups);
+    static unsigned resolveThreadCount(unsigned requested);
+    static void runInParallel(size_t taskCount, unsigned threadCount,
+                              const std::function<void(size_t, unsigned)> &task);
+    static llvm::SmallVector<int, 32> convertIndexToFiltered(const GroupTable &groupTable);
 
     // 清空数据
     void clear();
+    void assignSymbolIds();
     void findCyclicGroups();
-    llvm::DenseSet<llvm::GlobalValue *> getCyclicGroupsContainingGlobalValue(llvm::GlobalValue *GV);
+    llvm::ArrayRef<SymbolId> getCyclicGroupContainingSymbol(SymbolId id) const;
+    uint32_t getInstructionCount(SymbolId id) const { return instructionCounts.empty() ? 0 : instructionCounts[id]; }
+    size_t predictEmissionFootprint(llvm::ArrayRef<SymbolId> group) const;
+    void buildGroupTable(std::vector<int> groupOfSymbol, size_t groupCount);
+    std::vector<llvm::GlobalValue *> getGroupGlobalValues(size_t group) const;
     llvm::SmallVector<llvm::SmallSetVector<int, 32>, 32> getGroupDependencies();
 
     // 函数名匹配相关方法
@@ -260,9 +410,26 @@ class BCCommon {
     void invalidateGlobalValueNameCache();
     bool isGlobalValueNameCacheValid() const;
     size_t getGlobalValueNameCacheSize() const;
-    void collectGlobalValuesFromConstant(llvm::Constant *C, llvm::DenseSet<llvm::GlobalValue *> &globalValueSet);
+    llvm::ArrayRef<SymbolId> resolveConstantReferences(const llvm::Constant *C, ConstantRefMemo &memo,
+                                                       const ConstantRefMemo *sharedMemo) const;
+    void precomputeInitializerReferences();
+    // 调用边提取规则的版本，记入分析缓存的键；collectCallEdges/collectSummaryEdges记录的边有变化时递增
+    static constexpr uint32_t CallEdgeRulesVersion = 3;
+    void collectCallEdges(llvm::GlobalValue *GV, CallEdgeList &edges, CallEdgeList &personalityEdges,
+                          CallEdgeScratch &scratch) const;
     void analyzeCallRelations();
-    llvm::GlobalValue *findGlobalValueFromUser(llvm::User *U);
+    bool collectEdges(CallEdgeList &allEdges, CallEdgeList &allPersonalityEdges);
+    void collectIREdges(CallEdgeList &allEdges, CallEdgeList &allPersonalityEdges);
+    bool collectSummaryEdges(CallEdgeList &allEdges, CallEdgeList &allPersonalityEdges);
+    void crossCheckEdges(const CallEdgeList &summaryEdges, const CallEdgeList &irEdges,
+                         llvm::ArrayRef<uint32_t> summaryInstructionCounts);
+    llvm::GlobalValue *findGlobalValueFromUser(llvm::User *U) const;
+    llvm::GlobalValue *findGlobalValueFromUser(llvm::User *U, ConstantOwnerMemo *memo) const;
+
+    // 惰性模块的按需物化
+    bool materializeFunction(llvm::Function &F);
+    static void dematerializeFunction(llvm::Function &F);
+    bool materializeModule();
 
   private:
     // 确保缓存有效的内部方法
@@ -0,0 +1,53 @@
+// compactor.h
+#ifndef BC_SPLITTER_COMPACTOR_H
+#define BC_SPLITTER_COMPACTOR_H
+
+#include "llvm/IR/Module.h"
+#include <cstddef>
+#include <string>
+
+// 压缩选项
+struct CompactionOptions {
+    // 删除没有引用的函数和全局变量声明
+    bool pruneDeclarations = true;
+    // 删除调试信息中已不存在的全局变量、子程序等
+    bool pruneDebugInfo = true;
+    // 丢弃参数、基本块和指令的名字
+    bool discardLocalNames = true;
+};
+
+// 一次压缩的统计
+struct CompactionStats {
+    size_t declarations = 0;
+    size_t comdats = 0;
+    size_t namedMetadata = 0;
+    size_t localNames = 0;
+    bool debugInfoPruned = false;
+
+    std::string getSummary() const;
+};
+
+/**
+ * @brief 拆分后分组模块的压缩
+ *
+ * 删除不再被引用的声明、没有成员的comdat、空的命名元数据，
+ * 清理编译单元中已经不存在的调试信息，并丢弃局部值的名字。
+ * 结构体类型归LLVMContext所有，bitcode写出时只包含仍被引用的类型，不需要单独处理。
+ */
+class ModuleCompactor {
+  public:
+    explicit ModuleCompactor(const CompactionOptions &options = CompactionOptions()) : options(options) {}
+
+    CompactionStats run(llvm::Module &M) const;
+
+  private:
+    static size_t pruneDeclarations(llvm::Module &M);
+    static size_t pruneComdats(llvm::Module &M);
+    static size_t pruneNamedMetadata(llvm::Module &M);
+    static bool pruneDebugInfo(llvm::Module &M);
+    static size_t discardLocalNames(llvm::Module &M);
+
+    CompactionOptions options;
+};
+
+#endif // BC_SPLITTER_COMPACTOR_H
@@ -2,6 +2,7 @@
 #ifndef BC_SPLITTER_CORE_H
 #define BC_SPLITTER_CORE_H
 
+#include "callgraph.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/GlobalValue.h"
 #include "llvm/IR/GlobalVariable.h"
@@ -44,6 +45,7 @@ struct GlobalValueInfo {
     bool isPreProcessed = false;
     bool isProcessed = false;
     int sequenceNumber = -1; // 只有无名对象才有序号，有名对象为-1
+    SymbolId symbolId = InvalidSymbolId; // 调用图中的稠密ID
 
     llvm::GlobalValue *globalvaluePtr = nullptr;
 
@@ -60,18 +62,9 @@ struct GlobalValueInfo {
     bool isLinkOnce = false;
     bool isCommon = false;
 
-    // 调用关系公共属性
+    // 调用关系公共属性，邻接关系保存在BCCommon的CSR调用图中
     int outDegree = 0;
     int inDegree = 0;
-    llvm::DenseSet<llvm::GlobalValue *> callers;
-    llvm::DenseSet<llvm::GlobalValue *> calleds;
-
-    // 函数特有属性
-    struct {
-        // personality函数（异常处理函数）
-        llvm::DenseSet<llvm::Function *> personalityCalledFunctions;
-        llvm::DenseSet<llvm::Function *> personalityCallerFunctions;
-    } funcSpecific;
 
     // 全局变量特有属性
     struct {
@@ -96,8 +89,9 @@ struct GlobalValueInfo {
     // 获取可见性描述
     std::string getVisibilityString() const;
 
-    // 获取完整信息字符串
-    std::string getFullInfo() const;
+    // 获取完整信息字符串，调用关系从调用图中读取
+    std::string getFullInfo(const CallGraph &callGraph, const CallGraph &personalityGraph,
+                            llvm::ArrayRef<llvm::GlobalValue *> symbols) const;
 
     // 获取简略信息字符串
     std::string getBriefInfo() const;
@@ -108,12 +102,6 @@ struct GlobalValueInfo {
     bool isUnnamed() const;
     // 从LLVM函数更新属性
     void updateAttributesFromLLVM();
-    // 判断指定函数的调用者是否全部在指定的组中
-    static bool areAllCallersInGroup(llvm::GlobalValue *GV, const llvm::DenseSet<llvm::GlobalValue *> &group,
-                                     const llvm::DenseMap<llvm::GlobalValue *, GlobalValueInfo> &globalValueMap);
-    // 判断指定函数的被调用者是否全部在指定的组中
-    static bool areAllCalledsInGroup(llvm::GlobalValue *GV, const llvm::DenseSet<llvm::GlobalValue *> &group,
-                                     const llvm::DenseMap<llvm::GlobalValue *, GlobalValueInfo> &globalValueMap);
 };
 
 // 分组模式枚举
@@ -0,0 +1,41 @@
+// extractor.h
+#ifndef BC_SPLITTER_EXTRACTOR_H
+#define BC_SPLITTER_EXTRACTOR_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/IR/GlobalValue.h"
+#include "llvm/IR/Module.h"
+#include <memory>
+
+/**
+ * @brief 按组从源模块中选择性抽取符号，生成新的模块
+ *
+ * 只克隆组内符号的定义（函数体、全局变量初始值），组内定义引用到的其他全局对象
+ * 在新模块中按需创建为声明；comdat和命名元数据（模块标志、调试信息等）一并复制。
+ * 别名和ifunc由其指向的对象（resolver函数）所在的组定义，保证每个别名恰好在一个输出中有定义。
+ * 与对整个模块CloneModule后再删除函数体相比，每组的工作量只与组本身的大小成正比。
+ *
+ * 新模块与源模块共享同一个LLVMContext。源模块中待抽取函数的函数体必须已经物化。
+ */
+class GroupExtractor {
+  public:
+    explicit GroupExtractor(const llvm::Module &sourceModule) : source(sourceModule) {}
+
+    /**
+     * @brief 抽取一组符号
+     *
+     * @param definitions 组内的全局对象，保留原有的定义和链接属性
+     * @param exported definitions中被组外引用的符号，局部链接会被提升为外部链接
+     * @param moduleName 新模块的标识
+     * @return 新模块，组外符号均为声明
+     */
+    std::unique_ptr<llvm::Module> extract(llvm::ArrayRef<llvm::GlobalValue *> definitions,
+                                          llvm::ArrayRef<llvm::GlobalValue *> exported,
+                                          llvm::StringRef moduleName) const;
+
+  private:
+    const llvm::Module &source;
+};
+
+#endif // BC_SPLITTER_EXTRACTOR_H
@@ -2,6 +2,8 @@
 #ifndef BC_SPLITTER_LINKER_H
 #define BC_SPLITTER_LINKER_H
 
+#include <atomic>
+#include <chrono>
 #include <future> // 包含std::promise和std::future
 #include <mutex>
 #include <string>
@@ -39,6 +41,12 @@ class BCLinker {
     llvm::DenseMap<int, std::shared_future<void>> phase1Futures;
     std::mutex phaseMutex;
 
+    // 两个阶段中ld.lld的累计耗时（微秒）
+    std::atomic<uint64_t> phase1Micros{0};
+    std::atomic<uint64_t> phase2Micros{0};
+
+    static uint64_t elapsedMicros(std::chrono::steady_clock::time_point start);
+
   public:
     BCLinker(BCCommon &commonRef);
 
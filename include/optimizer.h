@@ -3,10 +3,15 @@
 #define BC_SPLITTER_OPTIMIZER_H
 
 #include "logging.h"
+#include "telemetry.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/PassManager.h"
 #include "llvm/Passes/PassBuilder.h"
+#include "llvm/Passes/PassPlugin.h"
 #include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -14,11 +19,23 @@ namespace custom {
 
 // 优化器配置
 struct OptimizerConfig {
-    bool run_before_o2 = false; // 在 O2 优化前运行自定义 Pass
-    bool run_after_o2 = false;  // 在 O2 优化后运行自定义 Pass
     bool enable_debug = true;   // 启用调试输出
+    bool pre_link_only = false; // 只运行 LTO 预链接管道，主要优化留给链接时 LTO
+    std::string pre_o2_pipeline;  // 在 O2 之前运行的文本管道，可使用插件中的 Pass
+    std::string post_o2_pipeline; // 在 O2 之后运行的文本管道
 
-    static OptimizerConfig Default() { return OptimizerConfig{false, false, true}; }
+    static OptimizerConfig Default() { return OptimizerConfig(); }
+};
+
+// 一个分组的优化方案：按优化级别构建默认管道，或使用给定的文本管道
+struct OptimizationProfile {
+    llvm::OptimizationLevel Level = llvm::OptimizationLevel::O2;
+    std::string Pipeline; // 非空时代替按级别构建的默认管道，语法与 opt -passes 相同
+
+    // 解析 O0/O1/O2/O3/Os/Oz 或 pipeline:<文本管道>，文本管道在此检查语法
+    static bool parse(llvm::StringRef Spec, OptimizationProfile &Profile, std::string &Error);
+    // 方案的文本表示，也是优化器缓存管道的键
+    std::string getName() const;
 };
 
 // 自定义 Pass 基类接口
@@ -29,6 +46,8 @@ class CustomPass {
     virtual ~CustomPass() = default;
     virtual llvm::PreservedAnalyses run(llvm::Module &M, llvm::ModuleAnalysisManager &AM) = 0;
     virtual std::string getName() const = 0;
+    // 并行生成时每个工作线程的优化器持有自己的副本，Pass 实例不跨线程共享
+    virtual std::unique_ptr<CustomPass> clone() const = 0;
 };
 
 // 预定义的自定义 Pass 示例
@@ -40,6 +59,7 @@ class ExampleCustomPass : public CustomPass {
   public:
     llvm::PreservedAnalyses run(llvm::Module &M, llvm::ModuleAnalysisManager &AM) override;
     std::string getName() const override { return "ExampleCustomPass"; }
+    std::unique_ptr<CustomPass> clone() const override { return std::make_unique<ExampleCustomPass>(); }
 };
 
 // 函数类型的自定义 Pass
@@ -56,31 +76,85 @@ class LambdaCustomPass : public CustomPass {
     llvm::PreservedAnalyses run(llvm::Module &M, llvm::ModuleAnalysisManager &AM) override { return Func(M, AM); }
 
     std::string getName() const override { return Name; }
+    // 副本共用同一个函数对象的拷贝，其捕获的状态需要自行保证线程安全
+    std::unique_ptr<CustomPass> clone() const override { return std::make_unique<LambdaCustomPass>(Func, Name); }
+};
+
+// 把自定义 Pass 包装为新 Pass 管理器中的模块 Pass
+// 插桩回调只能看到适配器的类名，Recorder非空时由适配器按 Pass 自身的名字计时
+class CustomPassAdapter : public llvm::PassInfoMixin<CustomPassAdapter> {
+  private:
+    std::shared_ptr<CustomPass> Pass;
+    PassTimingRecorder *Recorder;
+
+  public:
+    explicit CustomPassAdapter(std::shared_ptr<CustomPass> Pass, PassTimingRecorder *Recorder = nullptr)
+        : Pass(std::move(Pass)), Recorder(Recorder) {}
+
+    llvm::PreservedAnalyses run(llvm::Module &M, llvm::ModuleAnalysisManager &AM) {
+        if (!Recorder)
+            return Pass->run(M, AM);
+        Recorder->enterCustomPass(Pass->getName());
+        llvm::PreservedAnalyses PA = Pass->run(M, AM);
+        Recorder->leaveCustomPass(M);
+        return PA;
+    }
+
+    // 自定义 Pass 不因 optnone 等属性被跳过
+    static bool isRequired() { return true; }
+};
+
+/**
+ * @brief 从命令行加载的 Pass 插件（.so）
+ *
+ * 插件在启动时、创建任何优化器之前加载，之后只读。每个 PassBuilder 构造后注册全部插件的回调：
+ * 插件中的 Pass 可以在文本管道（--pre-o2-passes、优化方案的 pipeline:）中按名字使用，
+ * 插件在扩展点注册的 Pass 也会加入按优化级别构建的默认管道。
+ */
+class PassPluginRegistry {
+  public:
+    static bool load(const std::string &Path, std::string &Error);
+    static void registerCallbacks(llvm::PassBuilder &PB);
+    static size_t size() { return plugins().size(); }
+
+  private:
+    static std::vector<llvm::PassPlugin> &plugins();
 };
 
 // 主要优化器类
 class CustomOptimizer {
   private:
+    // 插桩回调先于PassBuilder构造，注册分析时交给PassInstrumentationAnalysis
+    llvm::PassInstrumentationCallbacks PIC;
+    PassTimingRecorder Recorder;
     llvm::PassBuilder PB;
     custom::OptimizerConfig Config;
     Logger logger;
 
-    // 分析管理器
+    // 分析管理器，构造时注册一次，之后每次运行只清空分析结果
     std::unique_ptr<llvm::LoopAnalysisManager> LAM;
     std::unique_ptr<llvm::FunctionAnalysisManager> FAM;
     std::unique_ptr<llvm::CGSCCAnalysisManager> CGAM;
     std::unique_ptr<llvm::ModuleAnalysisManager> MAM;
 
+    // 按优化方案缓存的管道，每个方案第一次运行时构建，Pass列表或配置变化后全部重建
+    llvm::StringMap<std::unique_ptr<llvm::ModulePassManager>> Pipelines;
+
     // 自定义 Pass 列表
-    std::vector<std::unique_ptr<CustomPass>> PrePasses;
-    std::vector<std::unique_ptr<CustomPass>> PostPasses;
+    std::vector<std::shared_ptr<CustomPass>> PrePasses;
+    std::vector<std::shared_ptr<CustomPass>> PostPasses;
 
-    void initializeAnalysisManagers(llvm::Module &M);
+    void initializeAnalysisManagers();
+    bool addTextPipeline(llvm::ModulePassManager &MPM, llvm::StringRef Pipeline);
+    llvm::ModulePassManager *getPipeline(const OptimizationProfile &Profile);
+    bool buildPipeline(const OptimizationProfile &Profile, llvm::ModulePassManager &MPM);
+    // 分析结果引用模块中的IR，每次运行后清空，实例可以继续用于其他上下文中的模块
+    void releaseAnalyses();
 
   public:
     CustomOptimizer(const custom::OptimizerConfig &Config = custom::OptimizerConfig::Default());
 
-    // 添加自定义 Pass
+    // 添加自定义 Pass，before_o2 为 true 时在 O2 之前运行，否则在 O2 之后运行
     void addPass(std::unique_ptr<CustomPass> Pass, bool before_o2 = false);
 
     // 添加 Lambda Pass
@@ -89,14 +163,46 @@ class CustomOptimizer {
     // 清空所有自定义 Pass
     void clearPasses();
 
+    // 复制另一个优化器的自定义 Pass（逐个clone），追加到本优化器相同的位置
+    void copyPassesFrom(const CustomOptimizer &Other);
+
     // 运行优化（包含 O2 和自定义 Pass）
-    bool runOptimization(llvm::Module &M);
+    bool runOptimization(llvm::Module &M) { return runOptimization(M, OptimizationProfile()); }
+    // 按给定的优化方案运行；Telemetry非空时记录每个Pass的耗时和指令数变化
+    bool runOptimization(llvm::Module &M, const OptimizationProfile &Profile,
+                         OptimizationTelemetry *Telemetry = nullptr);
 
     // 设置配置
-    void setConfig(const custom::OptimizerConfig &NewConfig) { Config = NewConfig; }
+    void setConfig(const custom::OptimizerConfig &NewConfig) {
+        Config = NewConfig;
+        Pipelines.clear();
+    }
 
     // 获取配置
     const custom::OptimizerConfig &getConfig() const { return Config; }
+
+    // 注册内置自定义 Pass 的名字和全部插件，Recorder非空时内置 Pass 按自身名字计时
+    static void registerPassCallbacks(llvm::PassBuilder &PB, PassTimingRecorder *Recorder = nullptr);
+    // 检查文本管道能否解析（包括内置自定义 Pass 和插件中的 Pass）
+    static bool checkPipeline(llvm::StringRef Pipeline, std::string &Error);
+};
+
+/**
+ * @brief 每个工作线程一个可复用的优化器
+ *
+ * 单个CustomOptimizer不是线程安全的；池中实例按工作线程编号取用，各线程只访问自己的实例，
+ * 分析注册和O2管道构建在每个线程上只做一次，之后复用于该线程处理的所有分组。
+ * 每个实例使用原型优化器的配置，并持有原型中自定义 Pass 的独立副本。
+ */
+class OptimizerPool {
+  private:
+    std::vector<std::unique_ptr<CustomOptimizer>> Optimizers;
+
+  public:
+    OptimizerPool(unsigned WorkerCount, const CustomOptimizer &Prototype);
+
+    CustomOptimizer &get(unsigned Worker) { return *Optimizers[Worker]; }
+    size_t size() const { return Optimizers.size(); }
 };
 
 // 工具函数：优化并写入 bitcode 文件
@@ -0,0 +1,49 @@
+// profile.h
+#ifndef BC_SPLITTER_PROFILE_H
+#define BC_SPLITTER_PROFILE_H
+
+#include "optimizer.h"
+#include "llvm/ADT/StringRef.h"
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 从配置文件读取的分组优化方案表
+ *
+ * 每行一条规则 `<选择器> = <方案>`，'#'之后为注释。选择器可以是：
+ *   default     未命中其他规则的分组
+ *   public      公共组（0号组）
+ *   group:<N>   组号为N的分组（与Config::packageStrings下标加1对应）
+ *   <包名>      该包以及以它为前缀的子包，例如 androidx.compose 覆盖 androidx.compose.runtime
+ * 方案为 O0/O1/O2/O3/Os/Oz，或 pipeline:<文本管道>（语法与 opt -passes 相同，可使用插件中的Pass）。
+ * 优先级：group:<N> 高于包名，包名取最长匹配；公共组先看 public，最后都落到 default。
+ */
+class OptimizationProfileTable {
+  public:
+    // 任一行有误时返回false，error给出行号和原因，表保持为空
+    bool load(llvm::StringRef path, std::string &error);
+    void clear();
+
+    // 按组号和该组对应的包名（公共组为空）选择方案
+    const custom::OptimizationProfile &select(size_t groupId, llvm::StringRef packageName) const;
+
+    size_t getRuleCount() const;
+
+  private:
+    struct PackageRule {
+        std::string pattern;
+        custom::OptimizationProfile profile;
+    };
+
+    bool addRule(llvm::StringRef selector, const custom::OptimizationProfile &profile, std::string &error);
+
+    custom::OptimizationProfile defaultProfile;
+    bool hasPublicProfile = false;
+    custom::OptimizationProfile publicProfile;
+    std::map<size_t, custom::OptimizationProfile> groupProfiles;
+    std::vector<PackageRule> packageRules;
+};
+
+#endif // BC_SPLITTER_PROFILE_H
@@ -0,0 +1,37 @@
+// scheduler.h
+#ifndef BC_SPLITTER_SCHEDULER_H
+#define BC_SPLITTER_SCHEDULER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+/**
+ * @brief 按预测内存占用做准入控制的计数信号量
+ *
+ * acquire在已占用量加上本次请求超过预算时阻塞，直到其他任务release；
+ * 单个请求本身超过预算时只在没有其他任务运行时放行，保证调度总能前进。
+ */
+class MemoryBudget {
+  public:
+    explicit MemoryBudget(size_t limitBytes) : limit(limitBytes) {}
+
+    void acquire(size_t bytes);
+    void release(size_t bytes);
+
+    size_t getLimit() const { return limit; }
+    // 运行期间同时占用的最大预测值
+    size_t getPeak() const;
+
+    // 物理内存大小（字节），无法获取时返回0
+    static size_t getPhysicalMemory();
+
+  private:
+    const size_t limit;
+    size_t inUse = 0;
+    size_t peak = 0;
+    mutable std::mutex mutex;
+    std::condition_variable released;
+};
+
+#endif // BC_SPLITTER_SCHEDULER_H
@@ -3,10 +3,17 @@
 #define BC_SPLITTER_SPLITTER_H
 
 #include "common.h"
+#include "compactor.h"
 #include "core.h"
+#include "extractor.h"
 #include "logging.h"
 #include "optimizer.h"
+#include "profile.h"
+#include "scheduler.h"
+#include "stringmatch.h"
+#include "symtab.h"
 #include "verifier.h"
+#include "writer.h"
 #include "llvm/Bitcode/BitcodeReader.h"
 #include "llvm/Bitcode/BitcodeWriter.h"
 #include "llvm/IR/Constants.h"
@@ -23,6 +30,7 @@
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Transforms/Utils/Cloning.h" // 包含 CloneModule 和 ValueToValueMapTy
+#include <atomic>
 #include <memory>
 #include <unordered_map>
 #include <vector>
@@ -36,9 +44,58 @@ class BCModuleSplitter {
     BCVerifier verifier;
     custom::CustomOptimizer optimizer;
 
+    // 每个包（Config::packageStrings下标）按最长匹配分到的符号ID
+    std::vector<std::vector<SymbolId>> packageMembers;
+    // 加载IR之前从符号表得到的预分组，关闭预分组或读取失败时为空
+    PreliminaryPlan preliminaryPlan;
+
+    // 分组优化方案表，以及按文件序号排列的各组方案
+    OptimizationProfileTable profileTable;
+    std::vector<custom::OptimizationProfile> fileProfiles;
+    // 按文件序号排列的优化遥测，每组只由生成它的线程写入
+    std::vector<custom::OptimizationTelemetry> fileTelemetry;
+    // 命令行给出的在O2前后运行的文本管道
+    std::string prePassPipeline;
+    std::string postPassPipeline;
+
     int totalGroups = 0;
+    // 各分组优化耗时之和（微秒），并行生成时由多个线程累加
+    std::atomic<uint64_t> optimizationMicros{0};
+    // 生成阶段的后台写盘线程，同步写出时为空
+    std::unique_ptr<AsyncFileWriter> outputWriter;
     SplitMode currentMode = MANUAL_MODE;
 
+    // 并行生成时一个分组独占的上下文和惰性源模块，写出后整体释放；
+    // 优化器按工作线程复用，每次运行后清空分析结果，不引用已释放的IR
+    struct EmissionContext {
+        llvm::LLVMContext context;
+        std::unique_ptr<llvm::Module> module;
+        // 以符号ID为下标，指向该上下文模块中的全局对象
+        std::vector<llvm::GlobalValue *> symbols;
+    };
+
+    // 一个待生成的分组
+    struct EmissionTask {
+        size_t groupId;
+        int fileIndex;
+        std::string filename;
+        // 预测的内存占用（字节）
+        size_t predictedBytes;
+    };
+
+    void planFromSymbolTable(llvm::MemoryBufferRef buffer);
+    void dumpRenamedBitcode(llvm::StringRef filename);
+    std::unique_ptr<llvm::MemoryBuffer> mergeBitcodeModules(std::vector<llvm::BitcodeModule> &modules,
+                                                            llvm::StringRef identifier);
+
+    custom::OptimizerConfig makeOptimizerConfig() const;
+    static std::string getPlacementName(OptimizationPlacement placement);
+    void assignOptimizationProfiles();
+    const custom::OptimizationProfile &getFileProfile(int fileIndex) const;
+    custom::OptimizationTelemetry *getFileTelemetry(int fileIndex);
+    void writeOptimizationReport(llvm::StringRef outputPrefix);
+    std::string getLinkerFlags(const custom::OptimizationProfile &profile) const;
+
     // 获取链接属性字符串表示
     std::string getLinkageString(llvm::GlobalValue::LinkageTypes linkage);
 
@@ -50,6 +107,7 @@ class BCModuleSplitter {
 
     // 配置
     void setCloneMode(bool enable);
+    void setPassPipelines(const std::string &prePipeline, const std::string &postPipeline);
 
     // 文件操作
     bool loadBCFile(llvm::StringRef filename);
@@ -60,15 +118,12 @@ class BCModuleSplitter {
     void generateGroupReport(llvm::StringRef outputPrefix);
 
     // 分组获取功能
-    void getGlobalValueGroup(int groupIndex);
-    llvm::DenseSet<llvm::GlobalValue *>
-    getOriginWithOutDegreeGlobalValues(int preGroupId, const llvm::DenseSet<llvm::GlobalValue *> &originGVs);
-    llvm::DenseSet<llvm::GlobalValue *>
-    getStronglyConnectedComponent(int preGroupId, const llvm::DenseSet<llvm::GlobalValue *> &originGVs);
+    void classifyPackageSymbols();
+    void labelPackageGroups();
 
     // BC文件创建
     bool createGlobalVariablesBCFile(const llvm::DenseSet<llvm::GlobalVariable *> &globals, llvm::StringRef filename);
-    bool createBCFile(const llvm::DenseSet<llvm::GlobalValue *> &group, llvm::StringRef filename, int groupIndex);
+    bool createBCFile(llvm::ArrayRef<SymbolId> group, llvm::StringRef filename, int groupIndex);
 
     // 核心拆分逻辑
     void splitBCFiles(llvm::StringRef outputPrefix);
@@ -79,16 +134,27 @@ class BCModuleSplitter {
 
     // 验证相关方法（包装器）
     void validateAllBCFiles(llvm::StringRef outputPrefix);
-    bool verifyAndFixBCFile(llvm::StringRef filename, const llvm::DenseSet<llvm::GlobalValue *> &expectedGroup);
+    bool verifyAndFixBCFile(llvm::StringRef filename, llvm::ArrayRef<llvm::GlobalValue *> expectedGroup);
     bool quickValidateBCFile(llvm::StringRef filename);
     void analyzeBCFileContent(llvm::StringRef filename);
     // 编译优化
     bool runOptimizationAndVerify(llvm::Module &M);
+    bool runOptimizationAndVerify(llvm::Module &M, custom::CustomOptimizer &moduleOptimizer,
+                                  const custom::OptimizationProfile &profile = custom::OptimizationProfile(),
+                                  custom::OptimizationTelemetry *telemetry = nullptr);
 
   private:
     // 私有辅助方法
-    bool createBCFileWithClone(const llvm::DenseSet<llvm::GlobalValue *> &group, llvm::StringRef filename,
-                               int groupIndex);
+    bool createBCFileWithClone(llvm::ArrayRef<SymbolId> group, llvm::StringRef filename, int groupIndex);
+    bool createBCFileWithExtraction(llvm::ArrayRef<SymbolId> group, llvm::StringRef filename, int groupIndex);
+    bool emitGroup(llvm::Module &source, llvm::ArrayRef<llvm::GlobalValue *> sourceSymbols,
+                   custom::CustomOptimizer &groupOptimizer, llvm::ArrayRef<SymbolId> group, llvm::StringRef filename,
+                   int groupIndex);
+    bool writeGroupModule(llvm::Module &M, llvm::StringRef filename, int groupIndex);
+    bool validateEmittedFile(int fileIndex);
+    // 并行生成
+    std::unique_ptr<EmissionContext> createEmissionContext();
+    int emitGroupsInParallel(llvm::StringRef outputPrefix, unsigned threadCount);
     // Clone模式处理
     void processClonedModuleGlobalValues(llvm::Module &M, const llvm::DenseSet<llvm::GlobalValue *> &targetGroup,
                                          const llvm::DenseSet<llvm::GlobalValue *> &externalGroup);
@@ -0,0 +1,110 @@
+// stringmatch.h
+#ifndef BC_SPLITTER_STRINGMATCH_H
+#define BC_SPLITTER_STRINGMATCH_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringRef.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Aho–Corasick 多模式子串匹配自动机
+ *
+ * 先用addPattern添加全部模式串，再调用build一次性生成失败链和输出链；
+ * 构建完成后只读，可被多个线程同时查询。状态转移以每个状态一段有序数组保存，
+ * 内存与模式串总长度成正比。一次扫描的代价为 O(|text| + 匹配数)。
+ */
+class AhoCorasickMatcher {
+  public:
+    static constexpr uint32_t InvalidPattern = UINT32_MAX;
+
+    AhoCorasickMatcher();
+
+    // 添加模式串并返回模式编号，重复的模式串返回已有编号；空串被忽略
+    uint32_t addPattern(llvm::StringRef pattern);
+    // 生成失败链和输出链，之后不能再添加模式串
+    void build();
+    void clear();
+
+    bool isBuilt() const { return built; }
+    size_t getPatternCount() const { return patternLengths.size(); }
+    size_t getStateCount() const { return stateCount; }
+    uint32_t getPatternLength(uint32_t patternId) const { return patternLengths[patternId]; }
+
+    /**
+     * @brief 对text中的每一次匹配调用callback(patternId, endOffset)
+     *
+     * endOffset为匹配结束位置（不含）。callback返回false时提前结束扫描。
+     * 模式串中不含'\0'时，文本中的'\0'会让自动机回到根状态，
+     * 因此可以用'\0'分隔多段文本一次扫描完成。
+     */
+    template <typename Callback> void forEachMatch(llvm::StringRef text, Callback &&callback) const {
+        if (!built)
+            return;
+        uint32_t state = 0;
+        for (size_t i = 0; i < text.size(); i++) {
+            state = next(state, static_cast<unsigned char>(text[i]));
+            for (uint32_t out = terminalPattern[state] != InvalidPattern ? state : outputLink[state]; out != 0;
+                 out = outputLink[out]) {
+                if (!callback(terminalPattern[out], i + 1))
+                    return;
+            }
+        }
+    }
+
+    // text是否包含任一模式串
+    bool containsAny(llvm::StringRef text) const;
+    // text中最长的匹配模式，等长时取编号较小者；无匹配时返回InvalidPattern
+    uint32_t findLongestMatch(llvm::StringRef text) const;
+
+  private:
+    // 从state读入字符c后的状态（沿失败链回退）
+    uint32_t next(uint32_t state, unsigned char c) const;
+    // 只查goto边，不存在时返回InvalidPattern
+    uint32_t child(uint32_t state, unsigned char c) const;
+
+    bool built = false;
+    uint32_t stateCount = 1;
+
+    // 构建期的trie边：(父状态 << 8 | 字符) -> 子状态，build后转为CSR
+    llvm::DenseMap<uint64_t, uint32_t> pendingEdges;
+
+    // CSR goto表：状态s的边为 [edgeOffsets[s], edgeOffsets[s+1])，按字符升序
+    std::vector<uint32_t> edgeOffsets;
+    std::vector<unsigned char> edgeLabels;
+    std::vector<uint32_t> edgeTargets;
+
+    std::vector<uint32_t> failureLink;
+    // 沿失败链最近的终止状态，0表示没有
+    std::vector<uint32_t> outputLink;
+    // 在该状态结束的模式编号
+    std::vector<uint32_t> terminalPattern;
+    std::vector<uint32_t> patternLengths;
+};
+
+/**
+ * @brief 按最长包名匹配把符号名分到包
+ *
+ * 包名按下标编号，重复的包名归第一次出现的下标。classify把所有名字以'\0'分隔拼接后
+ * 一次扫描，每个名字取最长的匹配包名，等长时取下标较小者。
+ */
+class PackageClassifier {
+  public:
+    static constexpr int Unclassified = -1;
+
+    explicit PackageClassifier(llvm::ArrayRef<std::string> packages);
+
+    // 返回每个名字所属的包下标，没有匹配时为Unclassified
+    std::vector<int> classify(llvm::ArrayRef<llvm::StringRef> names) const;
+
+    size_t getStateCount() const { return matcher.getStateCount(); }
+
+  private:
+    AhoCorasickMatcher matcher;
+    // 模式编号对应的包下标
+    std::vector<int> patternToPackage;
+};
+
+#endif // BC_SPLITTER_STRINGMATCH_H
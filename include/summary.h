@@ -0,0 +1,48 @@
+// summary.h
+#ifndef BC_SPLITTER_SUMMARY_H
+#define BC_SPLITTER_SUMMARY_H
+
+#include "callgraph.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/IR/GlobalValue.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/ModuleSummaryIndex.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+// 从摘要导出边时的统计
+struct SummaryEdgeStats {
+    size_t callEdges = 0;
+    size_t refEdges = 0;
+    // 摘要标为hot/critical的调用边
+    size_t hotCallEdges = 0;
+    // 有定义但在摘要中找不到的符号（GUID对不上，如摘要生成后被重命名的无名符号）
+    size_t missingSummaries = 0;
+};
+
+/**
+ * @brief 基于ModuleSummaryIndex的调用关系来源
+ *
+ * 摘要中每个函数有调用列表（含热度）、引用列表和指令数，全局变量有初始值的引用列表。
+ * 输入bitcode带有嵌入摘要时直接读取，不需要任何函数体；否则为已完整加载的模块现场构建。
+ * 摘要按GUID索引，符号通过GlobalValue::getGUID对应到符号ID。
+ */
+class SummaryCallGraphSource {
+  public:
+    // 读取输入中嵌入的摘要；没有摘要时返回nullptr且error为空
+    static std::unique_ptr<llvm::ModuleSummaryIndex> readEmbeddedIndex(llvm::MemoryBufferRef buffer,
+                                                                       std::string &error);
+    // 为模块构建摘要，调用前所有函数体必须已物化
+    static std::unique_ptr<llvm::ModuleSummaryIndex> buildIndex(const llvm::Module &M);
+
+    // 按符号ID导出调用/引用边 (调用者ID, 被调用者ID) 和函数指令数
+    static SummaryEdgeStats collectEdges(const llvm::ModuleSummaryIndex &index,
+                                         llvm::ArrayRef<llvm::GlobalValue *> symbols,
+                                         std::vector<CallGraph::Edge> &edges,
+                                         std::vector<uint32_t> &instructionCounts);
+};
+
+#endif // BC_SPLITTER_SUMMARY_H
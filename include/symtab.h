@@ -0,0 +1,34 @@
+// symtab.h
+#ifndef BC_SPLITTER_SYMTAB_H
+#define BC_SPLITTER_SYMTAB_H
+
+#include "stringmatch.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 只读符号表得到的预分组
+ *
+ * 直接从输入缓冲区读取bitcode中的irsymtab（缺失或版本不符时由LLVM只解析模块头重建），
+ * 不解析任何函数体，按包名对所有有定义的符号做最长匹配。结果只包含种子数量，
+ * 沿调用边的归属由完整IR分析之后的labelPackageGroups决定。
+ */
+struct PreliminaryPlan {
+    // 每个包（Config::packageStrings下标）命中的有定义符号数和其中的函数数
+    std::vector<size_t> packageSeeds;
+    std::vector<size_t> packageFunctions;
+    size_t moduleCount = 0;
+    size_t definedSymbols = 0;
+    size_t undefinedSymbols = 0;
+    // 没有命中任何包、暂归公共组的有定义符号数
+    size_t unclassified = 0;
+
+    bool isEmpty() const { return packageSeeds.empty(); }
+
+    static bool build(llvm::MemoryBufferRef buffer, const PackageClassifier &classifier, size_t packageCount,
+                      PreliminaryPlan &plan, std::string &error);
+};
+
+#endif // BC_SPLITTER_SYMTAB_H
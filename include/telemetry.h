@@ -0,0 +1,84 @@
+// telemetry.h
+#ifndef BC_SPLITTER_TELEMETRY_H
+#define BC_SPLITTER_TELEMETRY_H
+
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/PassInstrumentation.h"
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace custom {
+
+// 一个Pass或分析在一次模块优化中的累计耗时（不含嵌套在其中的其他Pass和分析）
+struct PassTiming {
+    std::string Name;
+    bool IsAnalysis = false;
+    unsigned Runs = 0;
+    double WallMs = 0;
+    double CpuMs = 0;
+};
+
+// 一个模块的优化遥测
+struct OptimizationTelemetry {
+    std::string Profile;
+    double WallMs = 0;
+    double CpuMs = 0;
+    uint64_t InstructionsBefore = 0;
+    uint64_t InstructionsAfter = 0;
+    // 每个模块级Pass结束后采样的最大指令数
+    uint64_t PeakInstructions = 0;
+    // 按墙钟时间降序
+    std::vector<PassTiming> Passes;
+
+    bool isEmpty() const { return Profile.empty(); }
+};
+
+/**
+ * @brief 通过PassInstrumentationCallbacks记录每个Pass的墙钟和CPU时间
+ *
+ * 回调只注册一次，start和finish之间的运行才被记录。计时以栈的方式进行：
+ * 进入嵌套的Pass或分析时暂停外层的计时，因此每项只包含自身的耗时，各项之和约等于总耗时。
+ * Pass管理器和适配器本身不单独计时。CPU时间取当前线程的CPU时钟，并行优化时互不干扰；
+ * 每个实例只能由一个线程使用，与CustomOptimizer相同。
+ */
+class PassTimingRecorder {
+  public:
+    void registerCallbacks(llvm::PassInstrumentationCallbacks &PIC);
+
+    void start(const llvm::Module &M, OptimizationTelemetry &Telemetry);
+    void finish(const llvm::Module &M);
+
+    // 自定义 Pass 共用同一个适配器类名，由适配器按 Pass 自身的名字单独计时
+    void enterCustomPass(llvm::StringRef Name);
+    void leaveCustomPass(const llvm::Module &M);
+
+    static uint64_t countInstructions(const llvm::Module &M);
+
+  private:
+    struct Frame {
+        size_t Entry;
+        std::chrono::steady_clock::time_point Wall;
+        double CpuMs;
+    };
+
+    void push(llvm::StringRef PassID, bool IsAnalysis);
+    void pop();
+    void sampleInstructions(const llvm::Module &M);
+    static double getThreadCpuMs();
+
+    OptimizationTelemetry *Active = nullptr;
+    // Pass和分析各自按名字索引Active->Passes中的下标
+    llvm::StringMap<size_t> PassIndex;
+    llvm::StringMap<size_t> AnalysisIndex;
+    std::vector<Frame> Stack;
+    std::chrono::steady_clock::time_point StartWall;
+    double StartCpuMs = 0;
+};
+
+} // namespace custom
+
+#endif // BC_SPLITTER_TELEMETRY_H
@@ -33,7 +33,7 @@ class BCVerifier {
     std::string getVisibilityString(llvm::GlobalValue::VisibilityTypes visibility);
 
     // 函数名映射构建
-    void buildGlobalValueNameMapsWithLog(const llvm::DenseSet<llvm::GlobalValue *> &group,
+    void buildGlobalValueNameMapsWithLog(llvm::ArrayRef<llvm::GlobalValue *> group,
                                          llvm::StringMap<llvm::GlobalValue *> &nameToGV,
                                          llvm::StringMap<std::string> &escapedToOriginal, std::ofstream &individualLog);
 
@@ -47,10 +47,10 @@ class BCVerifier {
 
     // 错误分析和修复
     llvm::StringSet<> analyzeVerifierErrorsWithLog(llvm::StringRef verifyOutput,
-                                                   const llvm::DenseSet<llvm::GlobalValue *> &group,
+                                                   llvm::ArrayRef<llvm::GlobalValue *> group,
                                                    std::ofstream &individualLog);
 
-    bool verifyAndFixBCFile(llvm::StringRef filename, const llvm::DenseSet<llvm::GlobalValue *> &expectedGroup);
+    bool verifyAndFixBCFile(llvm::StringRef filename, llvm::ArrayRef<llvm::GlobalValue *> expectedGroup);
 
     // 批量验证
     void validateAllBCFiles(llvm::StringRef outputPrefix, bool isCloneMode);
@@ -59,7 +59,7 @@ class BCVerifier {
     void analyzeBCFileContent(llvm::StringRef filename);
 
     // 重命名和修复
-    bool recreateBCFileWithExternalLinkage(const llvm::DenseSet<llvm::GlobalValue *> &group,
+    bool recreateBCFileWithExternalLinkage(llvm::ArrayRef<llvm::GlobalValue *> group,
                                            const llvm::StringSet<> &externalGVNames, llvm::StringRef filename,
                                            int groupIndex);
     void batchFixGlobalValueLinkageWithUnnamedSupport(llvm::Module &M, const llvm::StringSet<> &externalGVNames);
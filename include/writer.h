@@ -0,0 +1,68 @@
+// writer.h
+#ifndef BC_SPLITTER_WRITER_H
+#define BC_SPLITTER_WRITER_H
+
+#include "logging.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * @brief 后台写盘线程
+ *
+ * 生成线程把模块序列化到内存缓冲区后提交，立即继续下一组的抽取和优化；
+ * 写盘线程按提交顺序把缓冲区写入同目录的临时文件再rename到目标路径，
+ * 读者不会看到写了一半的文件。排队的字节数超过上限时submit阻塞，缓冲区占用有界。
+ */
+class AsyncFileWriter {
+  public:
+    // 写盘完成后在写盘线程中调用，参数为是否成功
+    using Completion = std::function<void(bool)>;
+
+    explicit AsyncFileWriter(size_t maxQueuedBytes);
+    ~AsyncFileWriter();
+
+    AsyncFileWriter(const AsyncFileWriter &) = delete;
+    AsyncFileWriter &operator=(const AsyncFileWriter &) = delete;
+
+    void submit(std::string path, llvm::SmallVector<char, 0> data, Completion onComplete);
+    // 等待已提交的写入全部完成
+    void drain();
+
+    // 排队字节数的峰值
+    size_t getPeakQueuedBytes() const;
+
+    // 先写临时文件再rename，失败时删除临时文件并在error中给出原因
+    static bool writeAtomically(llvm::StringRef path, llvm::ArrayRef<char> data, std::string &error);
+
+  private:
+    struct Job {
+        std::string path;
+        llvm::SmallVector<char, 0> data;
+        Completion onComplete;
+    };
+
+    void run();
+
+    const size_t maxQueued;
+    size_t queuedBytes = 0;
+    size_t peakQueued = 0;
+    // 已出队但尚未写完的任务数
+    size_t inFlight = 0;
+    bool stopping = false;
+    std::deque<Job> jobs;
+    mutable std::mutex mutex;
+    std::condition_variable jobReady;
+    std::condition_variable spaceFreed;
+    Logger logger;
+    std::thread worker;
+};
+
+#endif // BC_SPLITTER_WRITER_H
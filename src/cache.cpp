@@ -0,0 +1,149 @@
+// cache.cpp
+#include "cache.h"
+#include "writer.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/xxhash.h"
+#include <cstring>
+
+namespace {
+
+constexpr char CacheMagic[8] = {'B', 'C', 'S', 'A', 'N', 'A', 'L', 'Y'};
+// 文件布局变化时递增
+constexpr uint32_t CacheFormatVersion = 2;
+
+struct CacheHeader {
+    char magic[8];
+    uint32_t formatVersion;
+    uint32_t llvmVersion;
+    uint64_t inputHash;
+    uint64_t symbolHash;
+    uint32_t symbolCount;
+    uint32_t engine;
+    uint32_t rulesVersion;
+    uint32_t reserved;
+    uint64_t callEdgeCount;
+    uint64_t personalityEdgeCount;
+};
+
+template <typename T> void append(llvm::SmallVectorImpl<char> &buffer, const T *data, size_t count) {
+    const char *bytes = reinterpret_cast<const char *>(data);
+    buffer.append(bytes, bytes + sizeof(T) * count);
+}
+
+void appendEdges(llvm::SmallVectorImpl<char> &buffer, llvm::ArrayRef<CallGraph::Edge> edges) {
+    for (const CallGraph::Edge &edge : edges) {
+        uint32_t pair[2] = {edge.first, edge.second};
+        append(buffer, pair, 2);
+    }
+}
+
+void readEdges(const char *data, uint64_t count, std::vector<CallGraph::Edge> &edges) {
+    edges.resize(count);
+    const uint32_t *values = reinterpret_cast<const uint32_t *>(data);
+    for (uint64_t i = 0; i < count; i++) {
+        edges[i] = {values[2 * i], values[2 * i + 1]};
+    }
+}
+
+} // namespace
+
+std::string AnalysisCache::getPath(const AnalysisCacheKey &key) const {
+    return directory + "analysis_" + llvm::utohexstr(key.inputHash, /*LowerCase=*/true) + ".bin";
+}
+
+bool AnalysisCache::load(const AnalysisCacheKey &key, AnalysisSnapshot &snapshot, std::string &error) const {
+    auto bufferOrErr = llvm::MemoryBuffer::getFile(getPath(key), /*IsText=*/false, /*RequiresNullTerminator=*/false);
+    if (!bufferOrErr) {
+        error = bufferOrErr.getError().message();
+        return false;
+    }
+    llvm::StringRef contents = bufferOrErr.get()->getBuffer();
+    if (contents.size() < sizeof(CacheHeader)) {
+        error = "文件过短";
+        return false;
+    }
+
+    CacheHeader header;
+    std::memcpy(&header, contents.data(), sizeof(header));
+    if (std::memcmp(header.magic, CacheMagic, sizeof(CacheMagic)) != 0 || header.formatVersion != CacheFormatVersion ||
+        header.llvmVersion != LLVM_VERSION_MAJOR) {
+        error = "格式版本不匹配";
+        return false;
+    }
+    if (header.inputHash != key.inputHash || header.symbolHash != key.symbolHash ||
+        header.symbolCount != key.symbolCount || header.engine != key.engine ||
+        header.rulesVersion != key.rulesVersion) {
+        error = "缓存键不匹配";
+        return false;
+    }
+
+    uint64_t expectedSize = sizeof(CacheHeader) +
+                            sizeof(uint32_t) * (2 * header.callEdgeCount + 2 * header.personalityEdgeCount) +
+                            sizeof(uint32_t) * static_cast<uint64_t>(header.symbolCount);
+    if (contents.size() != expectedSize) {
+        error = "文件大小与文件头不一致";
+        return false;
+    }
+
+    // 文件头为8字节对齐，映射地址按页对齐，之后的uint32数组可以直接读取
+    const char *cursor = contents.data() + sizeof(CacheHeader);
+    readEdges(cursor, header.callEdgeCount, snapshot.callEdges);
+    cursor += sizeof(uint32_t) * 2 * header.callEdgeCount;
+    readEdges(cursor, header.personalityEdgeCount, snapshot.personalityEdges);
+    cursor += sizeof(uint32_t) * 2 * header.personalityEdgeCount;
+    const uint32_t *counts = reinterpret_cast<const uint32_t *>(cursor);
+    snapshot.instructionCounts.assign(counts, counts + header.symbolCount);
+
+    for (const auto *edges : {&snapshot.callEdges, &snapshot.personalityEdges}) {
+        for (const CallGraph::Edge &edge : *edges) {
+            if (edge.first >= header.symbolCount || edge.second >= header.symbolCount) {
+                error = "边的符号ID越界";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool AnalysisCache::store(const AnalysisCacheKey &key, const AnalysisSnapshot &snapshot, std::string &error) const {
+    if (snapshot.instructionCounts.size() != key.symbolCount) {
+        error = "指令数与符号数不一致";
+        return false;
+    }
+
+    CacheHeader header = {};
+    std::memcpy(header.magic, CacheMagic, sizeof(CacheMagic));
+    header.formatVersion = CacheFormatVersion;
+    header.llvmVersion = LLVM_VERSION_MAJOR;
+    header.inputHash = key.inputHash;
+    header.symbolHash = key.symbolHash;
+    header.symbolCount = key.symbolCount;
+    header.engine = key.engine;
+    header.rulesVersion = key.rulesVersion;
+    header.callEdgeCount = snapshot.callEdges.size();
+    header.personalityEdgeCount = snapshot.personalityEdges.size();
+
+    llvm::SmallVector<char, 0> buffer;
+    buffer.reserve(sizeof(header) + sizeof(uint32_t) * (2 * header.callEdgeCount + 2 * header.personalityEdgeCount +
+                                                        header.symbolCount));
+    append(buffer, &header, 1);
+    appendEdges(buffer, snapshot.callEdges);
+    appendEdges(buffer, snapshot.personalityEdges);
+    append(buffer, snapshot.instructionCounts.data(), snapshot.instructionCounts.size());
+
+    return AsyncFileWriter::writeAtomically(getPath(key), buffer, error);
+}
+
+uint64_t AnalysisCache::hashContents(llvm::StringRef contents) { return llvm::xxHash64(contents); }
+
+uint64_t AnalysisCache::hashNames(llvm::ArrayRef<llvm::StringRef> names) {
+    std::string joined;
+    for (llvm::StringRef name : names) {
+        joined += name;
+        joined += '\0';
+    }
+    return llvm::xxHash64(joined);
+}
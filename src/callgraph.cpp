@@ -0,0 +1,216 @@
+// callgraph.cpp
+#include "callgraph.h"
+#include <algorithm>
+
+/**
+ * @brief 由边列表构建正向和反向CSR邻接
+ *
+ * 边先按 (调用者, 被调用者) 排序去重，正向行因此天然有序；
+ * 反向行按排序后的边顺序计数填充，调用者同样按ID升序。
+ *
+ * @param symbolCount 符号总数，所有边的端点必须小于该值
+ * @param edges 边列表，构建后处于已排序去重状态
+ */
+void CallGraph::build(size_t symbolCount, std::vector<Edge> &edges) {
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    forwardOffsets.assign(symbolCount + 1, 0);
+    reverseOffsets.assign(symbolCount + 1, 0);
+    for (const auto &[from, to] : edges) {
+        forwardOffsets[from + 1]++;
+        reverseOffsets[to + 1]++;
+    }
+    for (size_t i = 0; i < symbolCount; i++) {
+        forwardOffsets[i + 1] += forwardOffsets[i];
+        reverseOffsets[i + 1] += reverseOffsets[i];
+    }
+
+    forwardTargets.resize(edges.size());
+    reverseTargets.resize(edges.size());
+    std::vector<uint32_t> reverseCursor(reverseOffsets.begin(), reverseOffsets.end() - 1);
+    for (size_t i = 0; i < edges.size(); i++) {
+        forwardTargets[i] = edges[i].second;
+        reverseTargets[reverseCursor[edges[i].second]++] = edges[i].first;
+    }
+}
+
+void CallGraph::clear() {
+    forwardOffsets.clear();
+    forwardTargets.clear();
+    reverseOffsets.clear();
+    reverseTargets.clear();
+}
+
+/**
+ * @brief 非递归Tarjan算法求强连通分量，并构建缩点DAG
+ *
+ * 显式维护 (符号, 下一条出边位置) 的调用栈，深调用链不会耗尽线程栈。
+ * 所有状态保存在以符号ID为下标的数组中。
+ */
+void SCCGraph::build(const CallGraph &callGraph) {
+    const size_t symbolCount = callGraph.getSymbolCount();
+    const uint32_t unvisited = UINT32_MAX;
+
+    sccOf.assign(symbolCount, unvisited);
+    sccOffsets.assign(1, 0);
+    sccMembers.clear();
+    sccMembers.reserve(symbolCount);
+
+    std::vector<uint32_t> indices(symbolCount, unvisited);
+    std::vector<uint32_t> lowlinks(symbolCount, 0);
+    std::vector<bool> onStack(symbolCount, false);
+    std::vector<SymbolId> stack;
+    std::vector<std::pair<SymbolId, uint32_t>> frames;
+    uint32_t index = 0;
+
+    auto visit = [&](SymbolId v) {
+        indices[v] = lowlinks[v] = index++;
+        stack.push_back(v);
+        onStack[v] = true;
+        frames.emplace_back(v, 0);
+    };
+
+    for (SymbolId root = 0; root < symbolCount; root++) {
+        if (indices[root] != unvisited)
+            continue;
+
+        visit(root);
+        while (!frames.empty()) {
+            SymbolId v = frames.back().first;
+            llvm::ArrayRef<SymbolId> calleds = callGraph.calleds(v);
+
+            // 继续处理v的下一条出边
+            if (frames.back().second < calleds.size()) {
+                SymbolId w = calleds[frames.back().second++];
+                if (indices[w] == unvisited) {
+                    visit(w);
+                } else if (onStack[w]) {
+                    // w在栈中，说明找到回边
+                    lowlinks[v] = std::min(lowlinks[v], indices[w]);
+                }
+                continue;
+            }
+
+            // v的出边处理完毕，如果v是强连通分量的根则弹出整个分量
+            if (lowlinks[v] == indices[v]) {
+                uint32_t scc = static_cast<uint32_t>(sccOffsets.size() - 1);
+                SymbolId w;
+                do {
+                    w = stack.back();
+                    stack.pop_back();
+                    onStack[w] = false;
+                    sccOf[w] = scc;
+                    sccMembers.push_back(w);
+                } while (w != v);
+                sccOffsets.push_back(static_cast<uint32_t>(sccMembers.size()));
+            }
+
+            frames.pop_back();
+            if (!frames.empty()) {
+                SymbolId parent = frames.back().first;
+                lowlinks[parent] = std::min(lowlinks[parent], lowlinks[v]);
+            }
+        }
+    }
+
+    // 构建缩点DAG：跨SCC的边映射为SCC之间的边
+    std::vector<CallGraph::Edge> sccEdges;
+    for (SymbolId from = 0; from < symbolCount; from++) {
+        for (SymbolId to : callGraph.calleds(from)) {
+            if (sccOf[from] != sccOf[to])
+                sccEdges.emplace_back(sccOf[from], sccOf[to]);
+        }
+    }
+    condensation.build(getSCCCount(), sccEdges);
+}
+
+void SCCGraph::clear() {
+    sccOf.clear();
+    sccOffsets.clear();
+    sccMembers.clear();
+    condensation.clear();
+}
+
+/**
+ * @brief 在缩点DAG上传播"唯一到达标签"
+ *
+ * 每个SCC只需记录 {无, 某个标签, 冲突} 三态之一：合并两个不同标签即为冲突。
+ * SCC编号降序为拓扑序，处理某个SCC时它的所有调用者都已处理完毕。
+ */
+std::vector<int> SCCGraph::propagateUniqueLabels(llvm::ArrayRef<int> seedLabels) const {
+    auto join = [](int current, int incoming) {
+        if (incoming == NoLabel || current == incoming)
+            return current;
+        if (current == NoLabel)
+            return incoming;
+        return ConflictLabel;
+    };
+
+    const size_t sccCount = getSCCCount();
+    std::vector<int> sccLabels(sccCount, NoLabel);
+    for (SymbolId id = 0; id < seedLabels.size() && id < sccOf.size(); id++) {
+        if (seedLabels[id] > 0)
+            sccLabels[sccOf[id]] = join(sccLabels[sccOf[id]], seedLabels[id]);
+    }
+
+    for (size_t i = sccCount; i-- > 0;) {
+        int label = sccLabels[i];
+        if (label == NoLabel)
+            continue;
+        for (uint32_t callee : condensation.calleds(static_cast<uint32_t>(i))) {
+            sccLabels[callee] = join(sccLabels[callee], label);
+        }
+    }
+
+    std::vector<int> labels(sccOf.size(), NoLabel);
+    for (SymbolId id = 0; id < sccOf.size(); id++) {
+        labels[id] = sccLabels[sccOf[id]];
+    }
+    return labels;
+}
+
+/**
+ * @brief 构建分组成员表和exported位图
+ *
+ * 分组号为负的符号不属于任何组。exported只需检查每个符号的调用者，整体为 O(V+E)。
+ */
+void GroupTable::build(std::vector<int> groupOfSymbol, size_t groupCount, const CallGraph &callGraph) {
+    groupOf = std::move(groupOfSymbol);
+
+    memberOffsets.assign(groupCount + 1, 0);
+    for (int group : groupOf) {
+        if (group >= 0 && static_cast<size_t>(group) < groupCount)
+            memberOffsets[group + 1]++;
+    }
+    for (size_t i = 0; i < groupCount; i++) {
+        memberOffsets[i + 1] += memberOffsets[i];
+    }
+
+    // 按符号ID顺序填充，组内天然有序
+    groupMembers.resize(memberOffsets[groupCount]);
+    std::vector<uint32_t> cursor(memberOffsets.begin(), memberOffsets.end() - 1);
+    for (SymbolId id = 0; id < groupOf.size(); id++) {
+        int group = groupOf[id];
+        if (group >= 0 && static_cast<size_t>(group) < groupCount)
+            groupMembers[cursor[group]++] = id;
+    }
+
+    exported.clear();
+    exported.resize(groupOf.size());
+    for (SymbolId id = 0; id < groupOf.size() && id < callGraph.getSymbolCount(); id++) {
+        for (SymbolId caller : callGraph.callers(id)) {
+            if (groupOf[caller] != groupOf[id]) {
+                exported.set(id);
+                break;
+            }
+        }
+    }
+}
+
+void GroupTable::clear() {
+    groupOf.clear();
+    memberOffsets.clear();
+    groupMembers.clear();
+    exported.clear();
+}
@@ -1,12 +1,17 @@
 #include "common.h"
+#include "cache.h"
+#include "summary.h"
+#include "writer.h"
 
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringSet.h"
 #include "llvm/Bitcode/BitcodeReader.h"
 #include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/IR/Constants.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/GlobalValue.h"
 #include "llvm/IR/GlobalVariable.h"
@@ -23,7 +28,10 @@
 #include <filesystem>
 #include <llvm/IR/IRBuilder.h>
 #include <llvm/Support/MemoryBuffer.h>
+#include <algorithm>
+#include <atomic>
 #include <stack>
+#include <thread>
 
 // 打印单个GroupInfo的详细信息
 void GroupInfo::printDetails() const {
@@ -55,9 +63,16 @@ BCCommon::~BCCommon() { clear(); }
 
 void BCCommon::clear() {
     module.reset();
+    inputBuffer.reset();
     globalValueMap.clear();
-    cyclicGroups.clear();
-    globalValueToGroupMap.clear();
+    symbols.clear();
+    symbolInfos.clear();
+    instructionCounts.clear();
+    callGraph.clear();
+    personalityGraph.clear();
+    sccGraph.clear();
+    groupTable.clear();
+    emissionRecords.clear();
     context = nullptr;
     GlobalValueNameMatcher.invalidateCache(); // 清理缓存
 }
@@ -72,12 +87,11 @@ bool BCCommon::isNumberString(llvm::StringRef str) {
     return true;
 }
 
-llvm::SmallVector<int, 32> BCCommon::convertIndexToFiltered(
-    const llvm::SmallVector<llvm::DenseSet<llvm::GlobalValue *>, 32> &globalValuesAllGroups) {
+llvm::SmallVector<int, 32> BCCommon::convertIndexToFiltered(const GroupTable &groupTable) {
     llvm::SmallVector<int, 32> pOriginalToNewIndex;
     int newIndex = 0;
-    for (unsigned i = 0; i < globalValuesAllGroups.size(); i++) {
-        if (!globalValuesAllGroups[i].empty()) {
+    for (unsigned i = 0; i < groupTable.getGroupCount(); i++) {
+        if (!groupTable.members(i).empty()) {
             pOriginalToNewIndex.push_back(newIndex++);
         } else {
             pOriginalToNewIndex.push_back(0);
@@ -86,240 +100,297 @@ llvm::SmallVector<int, 32> BCCommon::convertIndexToFiltered(
     return pOriginalToNewIndex;
 }
 
-std::string BCCommon::renameUnnamedGlobalValues(llvm::StringRef filename) {
-
-    llvm::ValueToValueMapTy VMap;
-    llvm::SMDiagnostic err;
-    std::string newfilename = "renamed_" + filename.str();
-    // 创建新的上下文
-    llvm::LLVMContext *context = new llvm::LLVMContext();
-
-    auto M = llvm::parseIRFile(filename, err, *context);
-    // 克隆模块
-    std::unique_ptr<llvm::Module> newM = llvm::CloneModule(*M, VMap);
-
+/**
+ * @brief 就地重命名模块中的无名全局变量、函数和别名
+ *
+ * 直接修改loadBCFile加载的模块，不再克隆模块或写出临时文件再重新解析。
+ * 命名规则与遍历顺序固定，同一输入得到的名字总是相同。
+ *
+ * @param M 要处理的模块
+ * @return 被重命名的全局对象数量
+ */
+unsigned BCCommon::renameUnnamedGlobalValues(llvm::Module &M) {
     // 计数器用于生成唯一名称
     unsigned globalVarCounter = 0;
     unsigned globalAliasCounter = 0;
     unsigned funcCounter = 0;
+    unsigned renamedCount = 0;
 
-    // 第一步：重命名全局变量
-    for (auto &GVar : newM->globals()) {
-        std::string oldName = GVar.getName().str();
-
-        // 检查是否未命名或名称以数字开头（通常是未命名的情况）
-        if (oldName.empty() || (oldName[0] >= '0' && oldName[0] <= '9')) {
+    // 检查是否未命名或名称以数字开头（通常是未命名的情况）
+    auto needsRename = [](llvm::StringRef name) { return name.empty() || (name[0] >= '0' && name[0] <= '9'); };
 
-            // 跳过以"llvm."开头的特殊全局变量
-            if (oldName.substr(0, 5) == "llvm.") {
-                continue;
-            }
-
-            // 生成新名称
-            std::string newName = "renamed_global_var_" + std::to_string(globalVarCounter++);
-
-            // 确保名称唯一
-            while (newM->getNamedValue(newName)) {
-                newName = "renamed_global_var_" + std::to_string(globalVarCounter++);
-            }
+    // 第一步：重命名全局变量
+    for (auto &GVar : M.globals()) {
+        if (!needsRename(GVar.getName()))
+            continue;
 
-            // 直接重命名
-            GVar.setName(newName);
-            // std::cout << "Renamed global variable: " << oldName << " -> " << newName << std::endl;
+        // 生成新名称，并确保名称唯一
+        std::string newName = "renamed_global_var_" + std::to_string(globalVarCounter++);
+        while (M.getNamedValue(newName)) {
+            newName = "renamed_global_var_" + std::to_string(globalVarCounter++);
         }
+        GVar.setName(newName);
+        renamedCount++;
     }
 
     // 第二步：重命名符号
-    for (auto &F : newM->functions()) {
-        std::string oldName = F.getName().str();
-
-        // 检查是否未命名或名称以数字开头
-        if (oldName.empty() || (oldName[0] >= '0' && oldName[0] <= '9')) {
-
-            // 跳过LLVM内部符号
-            if (oldName.substr(0, 5) == "llvm.") {
-                continue;
-            }
-
-            // 生成新名称
-            std::string newName = "renamed_func_" + std::to_string(funcCounter++);
-
-            // 确保名称唯一
-            while (newM->getNamedValue(newName)) {
-                newName = "renamed_func_" + std::to_string(funcCounter++);
-            }
+    for (auto &F : M.functions()) {
+        if (!needsRename(F.getName()))
+            continue;
 
-            // 直接重命名
-            F.setName(newName);
-            // std::cout << "Renamed function: " << oldName << " -> " << newName << std::endl;
+        std::string newName = "renamed_func_" + std::to_string(funcCounter++);
+        while (M.getNamedValue(newName)) {
+            newName = "renamed_func_" + std::to_string(funcCounter++);
         }
+        F.setName(newName);
+        renamedCount++;
     }
 
     // 第三步：重命名全局别名
-    for (auto &GA : newM->aliases()) {
-        std::string oldName = GA.getName().str();
-
-        if (oldName.empty() || (oldName[0] >= '0' && oldName[0] <= '9')) {
-
-            // 生成新名称
-            std::string newName = "renamed_alias_" + std::to_string(globalAliasCounter++);
-
-            // 确保名称唯一
-            while (newM->getNamedValue(newName)) {
-                newName = "renamed_alias_" + std::to_string(globalAliasCounter++);
-            }
+    for (auto &GA : M.aliases()) {
+        if (!needsRename(GA.getName()))
+            continue;
 
-            // 直接重命名
-            GA.setName(newName);
-            // std::cout << "Renamed alias: " << oldName << " -> " << newName << std::endl;
+        std::string newName = "renamed_alias_" + std::to_string(globalAliasCounter++);
+        while (M.getNamedValue(newName)) {
+            newName = "renamed_alias_" + std::to_string(globalAliasCounter++);
         }
+        GA.setName(newName);
+        renamedCount++;
     }
-    writeBitcodeSafely(*newM, newfilename);
-    return newfilename;
+
+    return renamedCount;
 }
 
 // 安全的bitcode写入方法
 bool BCCommon::writeBitcodeSafely(llvm::Module &M, llvm::StringRef filename) {
+    llvm::SmallVector<char, 0> buffer;
+    serializeBitcode(M, buffer);
+    return writeBitcodeSafely(buffer, filename);
+}
+
+// 先写同目录的临时文件再rename，output/下不会出现写了一半的文件
+bool BCCommon::writeBitcodeSafely(llvm::ArrayRef<char> bitcode, llvm::StringRef filename) {
     logger.logToFile("✓ 安全写入bitcode: " + filename.str());
 
-    std::error_code ec;
-    llvm::raw_fd_ostream outFile(config.workSpace + "output/" + filename.str(), ec, llvm::sys::fs::OF_None);
-    if (ec) {
-        logger.logError("无法创建文件: " + filename.str() + " - " + ec.message());
+    std::string error;
+    if (!AsyncFileWriter::writeAtomically(config.workSpace + "output/" + filename.str(), bitcode, error)) {
+        logger.logError("无法写入文件: " + filename.str() + " - " + error);
         return false;
     }
+    logger.log("✓ 成功写入: " + filename.str());
+    return true;
+}
 
-    try {
-        llvm::WriteBitcodeToFile(M, outFile);
-        outFile.close();
-        logger.log("✓ 成功写入: " + filename.str());
+void BCCommon::serializeBitcode(llvm::Module &M, llvm::SmallVectorImpl<char> &buffer) {
+    llvm::raw_svector_ostream out(buffer);
+    llvm::WriteBitcodeToFile(M, out);
+}
+
+/**
+ * @brief 采集模块中定义的简略信息和链接属性统计
+ *
+ * 口径与分组报告一致：有初始值的全局变量和有函数体的函数，按模块顺序。
+ */
+void BCCommon::captureModuleSummary(llvm::Module &M, EmissionRecord &record) {
+    record.symbolBriefs.clear();
+    record.globalVariableStats = AttributeStats();
+    record.functionStats = AttributeStats();
+    record.hasKonanCxaDemangle = false;
+
+    for (llvm::GlobalVariable &GVar : M.globals()) {
+        if (!GVar.hasInitializer())
+            continue;
+        GlobalValueInfo info(&GVar, 0);
+        record.symbolBriefs.push_back(info.getBriefInfo());
+        record.globalVariableStats.addInfo(info);
+    }
+
+    for (llvm::Function &F : M) {
+        if (F.isDeclaration())
+            continue;
+        GlobalValueInfo info(&F, 0);
+        record.symbolBriefs.push_back(info.getBriefInfo());
+        record.functionStats.addInfo(info);
+        if (info.displayName == "Konan_cxa_demangle")
+            record.hasKonanCxaDemangle = true;
+    }
+}
+
+// 从磁盘重新解析已写出的文件，重新采集记录并验证（仅在paranoidReparse时使用）
+bool BCCommon::reparseEmissionRecord(EmissionRecord &record) {
+    llvm::LLVMContext tempContext;
+    llvm::SMDiagnostic err;
+    auto M = llvm::parseIRFile(config.workSpace + "output/" + record.filename, err, tempContext);
+    if (!M) {
+        record.moduleValid = false;
+        record.verifyErrors = "无法加载文件: " + err.getMessage().str();
+        return false;
+    }
+
+    captureModuleSummary(*M, record);
+    std::string verifyResult;
+    llvm::raw_string_ostream rso(verifyResult);
+    record.moduleValid = !llvm::verifyModule(*M, &rso);
+    record.verifyErrors = rso.str();
+    return true;
+}
+
+// 物化惰性模块中的单个函数体，已物化或非惰性模块直接返回true
+bool BCCommon::materializeFunction(llvm::Function &F) {
+    if (!F.isMaterializable())
         return true;
-    } catch (const std::exception &e) {
-        logger.logError("写入bitcode时发生异常: " + std::string(e.what()));
-        llvm::sys::fs::remove(filename);
+
+    if (llvm::Error err = F.materialize()) {
+        logger.logError("物化函数体失败: " + F.getName().str() + " - " + llvm::toString(std::move(err)));
         return false;
     }
+    return true;
 }
 
 /**
- * @brief 检测并记录所有存在循环调用的符号组
+ * @brief 丢弃已物化的函数体并重新标记为可物化
  *
- * 使用Tarjan算法查找符号调用图中的强连通分量（SCC）
- * 强连通分量即存在循环调用的符号组
+ * 等价于LLVM早期的 GVMaterializer::dematerialize：函数体可以之后从输入bitcode再次读取。
+ * personality/prefix/prologue 在模块级解析，dropAllReferences 会清掉它们，需要恢复；
+ * 含有被取地址基本块（blockaddress）的函数体不能安全丢弃，保持物化状态。
  */
-void BCCommon::findCyclicGroups() {
-    cyclicGroups.clear();
-    globalValueToGroupMap.clear();
-
-    if (globalValueMap.empty()) {
-        logger.logWarning("GlobalValueMap is empty, no cyclic groups to find.");
+void BCCommon::dematerializeFunction(llvm::Function &F) {
+    if (F.isDeclaration() || F.isMaterializable())
         return;
+
+    for (llvm::BasicBlock &BB : F) {
+        if (BB.hasAddressTaken())
+            return;
     }
 
-    // 构建调用图
-    llvm::DenseMap<llvm::GlobalValue *, llvm::DenseSet<llvm::GlobalValue *>> callGraph;
-    llvm::DenseMap<llvm::GlobalValue *, int> indices;
-    llvm::DenseMap<llvm::GlobalValue *, int> lowlinks;
-    llvm::DenseMap<llvm::GlobalValue *, bool> onStack;
-    std::stack<llvm::GlobalValue *> stack;
-    int index = 0;
+    llvm::Constant *personality = F.hasPersonalityFn() ? F.getPersonalityFn() : nullptr;
+    llvm::Constant *prefix = F.hasPrefixData() ? F.getPrefixData() : nullptr;
+    llvm::Constant *prologue = F.hasPrologueData() ? F.getPrologueData() : nullptr;
 
-    // 初始化调用图
-    for (auto &pair : globalValueMap) {
-        llvm::GlobalValue *GV = pair.first;
-        callGraph[GV] = llvm::DenseSet<llvm::GlobalValue *>();
+    F.dropAllReferences();
+    F.setIsMaterializable(true);
 
-        // 添加直接调用关系
-        for (auto calledFunc : pair.second.calleds) {
-            if (globalValueMap.find(calledFunc) != globalValueMap.end()) {
-                callGraph[GV].insert(calledFunc);
-            }
-        }
+    if (personality)
+        F.setPersonalityFn(personality);
+    if (prefix)
+        F.setPrefixData(prefix);
+    if (prologue)
+        F.setPrologueData(prologue);
+}
+
+// 物化整个模块（克隆模块之前需要完整的函数体）
+bool BCCommon::materializeModule() {
+    if (!module)
+        return false;
+
+    if (llvm::Error err = module->materializeAll()) {
+        logger.logError("物化模块失败: " + llvm::toString(std::move(err)));
+        return false;
     }
+    return true;
+}
 
-    // Tarjan算法实现
-    std::function<void(llvm::GlobalValue *)> strongConnect;
-    strongConnect = [&](llvm::GlobalValue *v) {
-        indices[v] = index;
-        lowlinks[v] = index;
-        index++;
-        stack.push(v);
-        onStack[v] = true;
-
-        // 遍历所有邻居（被调用的符号）
-        for (auto w : callGraph[v]) {
-            if (indices.find(w) == indices.end()) {
-                // w未访问过
-                strongConnect(w);
-                lowlinks[v] = std::min(lowlinks[v], lowlinks[w]);
-            } else if (onStack[w]) {
-                // w在栈中，说明找到回边
-                lowlinks[v] = std::min(lowlinks[v], indices[w]);
-            }
-        }
+/**
+ * @brief 为globalValueMap中的全局对象分配稠密符号ID
+ *
+ * 按模块顺序（先全局变量后函数）编号，同一输入得到的ID总是相同。
+ * 分配之后globalValueMap不应再增删元素，symbolInfos直接指向其中的值。
+ */
+void BCCommon::assignSymbolIds() {
+    symbols.clear();
+    symbolInfos.clear();
+    if (!module)
+        return;
 
-        // 如果v是强连通分量的根
-        if (lowlinks[v] == indices[v]) {
-            llvm::DenseSet<llvm::GlobalValue *> scc;
-            llvm::GlobalValue *w;
-            do {
-                w = stack.top();
-                stack.pop();
-                onStack[w] = false;
-                scc.insert(w);
-            } while (w != v);
-
-            // 只记录非平凡的强连通分量（大小>1）
-            if (scc.size() > 1) {
-                cyclicGroups.push_back(scc);
-                int groupIndex = cyclicGroups.size() - 1;
-
-                // 更新符号到组的映射
-                for (auto GV : scc) {
-                    globalValueToGroupMap[GV].push_back(groupIndex);
-                }
-            }
-        }
+    symbols.reserve(globalValueMap.size());
+    symbolInfos.reserve(globalValueMap.size());
+    auto assign = [&](llvm::GlobalValue &GV) {
+        auto it = globalValueMap.find(&GV);
+        if (it == globalValueMap.end())
+            return;
+        it->second.symbolId = static_cast<SymbolId>(symbols.size());
+        symbols.push_back(&GV);
+        symbolInfos.push_back(&it->second);
     };
-
-    // 对每个未访问的符号执行算法
-    for (auto &pair : globalValueMap) {
-        llvm::GlobalValue *GV = pair.first;
-        if (indices.find(GV) == indices.end()) {
-            strongConnect(GV);
-        }
+    for (llvm::GlobalVariable &GVar : module->globals()) {
+        assign(GVar);
     }
+    for (llvm::Function &F : *module) {
+        assign(F);
+    }
+}
 
-    logger.logToFile("找到的循环群总数: " + std::to_string(cyclicGroups.size()));
+// 查询全局对象的符号ID，不在globalValueMap中时返回InvalidSymbolId
+// 别名和ifunc本身不分配符号ID，按其指向的对象（resolver函数）计算，与抽取时的归属一致
+SymbolId BCCommon::getSymbolId(const llvm::GlobalValue *GV) const {
+    if (const auto *GA = llvm::dyn_cast_or_null<llvm::GlobalAlias>(GV))
+        GV = GA->getAliaseeObject();
+    else if (const auto *GI = llvm::dyn_cast_or_null<llvm::GlobalIFunc>(GV))
+        GV = GI->getResolverFunction();
+    auto it = globalValueMap.find(GV);
+    return it == globalValueMap.end() ? InvalidSymbolId : it->second.symbolId;
 }
 
 /**
- * @brief 根据llvm::GlobalValue*查询符号所在的循环调用组
- * @param GV 要查询的符号指针
- * @return 包含该符号的所有循环调用组（每个组是一个符号集合）
+ * @brief 检测并记录所有存在循环调用的符号组
+ *
+ * 在CSR调用图上运行非递归Tarjan算法查找强连通分量（SCC），同时构建缩点DAG。
+ * 成员数大于1的强连通分量即存在循环调用的符号组
  */
+void BCCommon::findCyclicGroups() {
+    sccGraph.clear();
 
-llvm::DenseSet<llvm::GlobalValue *> BCCommon::getCyclicGroupsContainingGlobalValue(llvm::GlobalValue *GV) {
-    if (!GV) {
-        logger.logWarning("查询时提供的符号指针为空。");
-        return llvm::DenseSet<llvm::GlobalValue *>();
+    if (symbols.empty()) {
+        logger.logWarning("GlobalValueMap is empty, no cyclic groups to find.");
+        return;
     }
 
-    auto it = globalValueToGroupMap.find(GV);
-    if (it == globalValueToGroupMap.end()) {
-        return llvm::DenseSet<llvm::GlobalValue *>();
+    sccGraph.build(callGraph);
+
+    size_t cyclicGroupCount = 0;
+    for (uint32_t scc = 0; scc < sccGraph.getSCCCount(); scc++) {
+        if (sccGraph.isCyclic(scc))
+            cyclicGroupCount++;
     }
 
-    llvm::DenseSet<llvm::GlobalValue *> allRelateds;
+    logger.logToFile("强连通分量总数: " + std::to_string(sccGraph.getSCCCount()) + ", 缩点DAG边数: " +
+                     std::to_string(sccGraph.getCondensation().getEdgeCount()));
+    logger.logToFile("找到的循环群总数: " + std::to_string(cyclicGroupCount));
+}
 
-    // 收集所有相关符号
-    for (int groupIndex : it->second) {
-        if (groupIndex >= 0 && groupIndex < cyclicGroups.size()) {
-            allRelateds.insert(cyclicGroups[groupIndex].begin(), cyclicGroups[groupIndex].end());
-        }
+/**
+ * @brief 根据符号ID查询符号所在的循环调用组
+ * @param id 要查询的符号ID
+ * @return 循环调用组成员的连续视图（不复制），不在循环组中时为空
+ */
+llvm::ArrayRef<SymbolId> BCCommon::getCyclicGroupContainingSymbol(SymbolId id) const {
+    if (id >= symbols.size() || sccGraph.getSCCCount() == 0) {
+        return {};
     }
+    uint32_t scc = sccGraph.getSCC(id);
+    return sccGraph.isCyclic(scc) ? sccGraph.members(scc) : llvm::ArrayRef<SymbolId>();
+}
+
+/**
+ * @brief 由每个符号的分组号构建分组表
+ *
+ * @param groupOfSymbol 以符号ID为下标的分组号
+ * @param groupCount 分组总数（含公共组0）
+ */
+void BCCommon::buildGroupTable(std::vector<int> groupOfSymbol, size_t groupCount) {
+    groupTable.build(std::move(groupOfSymbol), groupCount, callGraph);
+    logger.logToFile("分组表构建完成: " + std::to_string(groupCount) + " 个分组, " +
+                     std::to_string(groupTable.getExportedCount()) + " 个符号被组外调用");
+}
 
-    return allRelateds;
+// 获取组成员对应的全局对象（按符号ID顺序）
+std::vector<llvm::GlobalValue *> BCCommon::getGroupGlobalValues(size_t group) const {
+    std::vector<llvm::GlobalValue *> result;
+    for (SymbolId id : groupTable.members(group)) {
+        result.push_back(symbols[id]);
+    }
+    return result;
 }
 
 /**
@@ -330,9 +401,7 @@ llvm::DenseSet<llvm::GlobalValue *> BCCommon::getCyclicGroupsContainingGlobalVal
  *         如果calleds中的符号不在globalValueMap中，跳过该符号
  */
 llvm::SmallVector<llvm::SmallSetVector<int, 32>, 32> BCCommon::getGroupDependencies() {
-    auto &globalValueMap = getGlobalValueMap();
-    auto &globalValuesAllGroups = getGlobalValuesAllGroups();
-    llvm::SmallVector<int, 32> cacheMapForGVGroups = convertIndexToFiltered(globalValuesAllGroups);
+    llvm::SmallVector<int, 32> cacheMapForGVGroups = convertIndexToFiltered(groupTable);
 
     int maxGroupIndex = -1;
     for (int i = 0; i < cacheMapForGVGroups.size(); i++) {
@@ -347,21 +416,17 @@ llvm::SmallVector<llvm::SmallSetVector<int, 32>, 32> BCCommon::getGroupDependenc
     llvm::SmallVector<llvm::SmallSetVector<int, 32>, 32> groupDependencies;
     groupDependencies.resize(maxGroupIndex + 1);
 
-    for (const auto &pair : globalValueMap) {
-        const GlobalValueInfo &gvInfo = pair.second;
-        int gvIndex = gvInfo.groupIndex;
+    for (SymbolId id = 0; id < symbolInfos.size(); id++) {
+        int gvIndex = symbolInfos[id]->groupIndex;
 
         if (gvIndex < 0) {
             continue;
         }
 
-        for (llvm::GlobalValue *called : gvInfo.calleds) {
-            auto calledIt = globalValueMap.find(called);
-            if (calledIt != globalValueMap.end()) {
-                int groupIdx = calledIt->second.groupIndex;
-                if (groupIdx >= 0 && groupIdx != gvIndex) {
-                    groupDependencies[gvIndex].insert(groupIdx);
-                }
+        for (SymbolId called : callGraph.calleds(id)) {
+            int groupIdx = symbolInfos[called]->groupIndex;
+            if (groupIdx >= 0 && groupIdx != gvIndex) {
+                groupDependencies[gvIndex].insert(groupIdx);
             }
         }
     }
@@ -400,10 +465,7 @@ llvm::StringSet<> BCCommon::getMatchingGlobalValueNames(llvm::StringRef str) {
 
     llvm::StringSet<> result;
     for (const auto &entry : matches) {
-        llvm::StringRef key = entry.getKey();
-        if (str.find(key) != llvm::StringRef::npos) {
-            result.insert(key);
-        }
+        result.insert(entry.getKey());
     }
     return result;
 }
@@ -420,16 +482,10 @@ llvm::DenseSet<llvm::GlobalValue *> BCCommon::getMatchingGlobalValues(llvm::Stri
     return result;
 }
 
-// 获取首个匹配的符号指针
+// 获取首个匹配的符号指针（字符串中最先出现的符号名），无匹配时返回nullptr
 llvm::GlobalValue *BCCommon::getFirstMatchingGlobalValue(llvm::StringRef str) {
     ensureCacheValid();
-    auto matches = GlobalValueNameMatcher.getMatchingGlobalValues(str);
-
-    llvm::GlobalValue *result;
-    for (const auto &match : matches) {
-        result = match.second;
-    }
-    return result;
+    return GlobalValueNameMatcher.getFirstMatchingGlobalValue(str);
 }
 
 // 获取缓存状态
@@ -437,406 +493,664 @@ bool BCCommon::isGlobalValueNameCacheValid() const { return GlobalValueNameMatch
 
 size_t BCCommon::getGlobalValueNameCacheSize() const { return GlobalValueNameMatcher.getCacheSize(); }
 
-// 用于从常量中收集GlobalValue（包括函数和全局变量）
-void BCCommon::collectGlobalValuesFromConstant(llvm::Constant *C, llvm::DenseSet<llvm::GlobalValue *> &globalValueSet) {
-    if (!C)
-        return;
-
-    // 如果是GlobalValue本身
-    if (auto *GV = llvm::dyn_cast<llvm::GlobalValue>(C)) {
-        globalValueSet.insert(GV);
-        return;
-    }
+/**
+ * @brief 解析常量引用的符号ID列表（有序去重），结果写入缓存表
+ *
+ * 只有常量表达式和聚合常量会被缓存；GlobalValue和BlockAddress作为叶子直接展开为符号ID，
+ * 其他常量（ConstantInt、ConstantFP、ConstantDataSequential等）不会引用GlobalValue。
+ * 常量的操作数不会改变，缓存在整个分析过程中有效。
+ *
+ * @param C 要解析的常量
+ * @param memo 当前线程可写的缓存表
+ * @param sharedMemo 只读的共享缓存表（全局变量初始值），可以为空
+ * @return 引用的符号ID列表，指向缓存表中的存储
+ */
+llvm::ArrayRef<SymbolId> BCCommon::resolveConstantReferences(const llvm::Constant *C, ConstantRefMemo &memo,
+                                                             const ConstantRefMemo *sharedMemo) const {
+    if (!C || !(llvm::isa<llvm::ConstantExpr>(C) || llvm::isa<llvm::ConstantAggregate>(C)))
+        return {};
 
-    // 如果是GlobalAlias，获取其目标
-    if (auto *GA = llvm::dyn_cast<llvm::GlobalAlias>(C)) {
-        if (auto *aliasee = GA->getAliasee()) {
-            collectGlobalValuesFromConstant(llvm::dyn_cast<llvm::Constant>(aliasee), globalValueSet);
-        }
-        return;
+    if (sharedMemo) {
+        auto sharedIt = sharedMemo->find(C);
+        if (sharedIt != sharedMemo->end())
+            return sharedIt->second;
     }
+    auto memoIt = memo.find(C);
+    if (memoIt != memo.end())
+        return memoIt->second;
+
+    std::vector<SymbolId> refs;
+    for (const llvm::Use &operand : C->operands()) {
+        const auto *child = llvm::dyn_cast<llvm::Constant>(operand.get());
+        if (!child)
+            continue;
 
-    // 处理常量表达式
-    if (auto *CE = llvm::dyn_cast<llvm::ConstantExpr>(C)) {
-        // 递归处理常量表达式的操作数
-        for (unsigned i = 0, e = CE->getNumOperands(); i < e; ++i) {
-            collectGlobalValuesFromConstant(llvm::cast<llvm::Constant>(CE->getOperand(i)), globalValueSet);
+        const llvm::GlobalValue *GV = llvm::dyn_cast<llvm::GlobalValue>(child);
+        if (auto *BA = llvm::dyn_cast<llvm::BlockAddress>(child))
+            GV = BA->getFunction();
+        if (GV) {
+            SymbolId id = getSymbolId(GV);
+            if (id != InvalidSymbolId)
+                refs.push_back(id);
+            continue;
         }
-        return;
-    }
 
-    // 处理聚合常量
-    if (auto *CA = llvm::dyn_cast<llvm::ConstantArray>(C)) {
-        for (unsigned i = 0, e = CA->getNumOperands(); i < e; ++i) {
-            collectGlobalValuesFromConstant(CA->getOperand(i), globalValueSet);
-        }
-        return;
+        llvm::ArrayRef<SymbolId> childRefs = resolveConstantReferences(child, memo, sharedMemo);
+        refs.insert(refs.end(), childRefs.begin(), childRefs.end());
     }
+    std::sort(refs.begin(), refs.end());
+    refs.erase(std::unique(refs.begin(), refs.end()), refs.end());
 
-    if (auto *CS = llvm::dyn_cast<llvm::ConstantStruct>(C)) {
-        for (unsigned i = 0, e = CS->getNumOperands(); i < e; ++i) {
-            collectGlobalValuesFromConstant(CS->getOperand(i), globalValueSet);
-        }
-        return;
-    }
+    // vector移动时保留堆存储，返回的视图在缓存表扩容后仍然有效
+    return memo.try_emplace(C, std::move(refs)).first->second;
+}
 
-    if (auto *CV = llvm::dyn_cast<llvm::ConstantVector>(C)) {
-        for (unsigned i = 0, e = CV->getNumOperands(); i < e; ++i) {
-            collectGlobalValuesFromConstant(CV->getOperand(i), globalValueSet);
+/**
+ * @brief 预先解析所有全局变量初始值引用的符号
+ *
+ * 在并行扫描之前由主线程调用一次，结果作为只读共享缓存供所有线程使用；
+ * 函数体中对同一全局变量的大量load和常量操作数都直接命中这里。
+ */
+void BCCommon::precomputeInitializerReferences() {
+    initializerRefMemo.clear();
+    for (llvm::GlobalValue *GV : symbols) {
+        if (auto *GVar = llvm::dyn_cast<llvm::GlobalVariable>(GV)) {
+            if (GVar->hasInitializer())
+                (void)resolveConstantReferences(GVar->getInitializer(), initializerRefMemo, nullptr);
         }
-        return;
-    }
-
-    // 处理BlockAddress
-    if (auto *BA = llvm::dyn_cast<llvm::BlockAddress>(C)) {
-        llvm::Function *F = BA->getFunction();
-        globalValueSet.insert(F);
-        return;
     }
-
-    // 其他常量类型，如ConstantInt、ConstantFP、ConstantDataSequential等，不会引用GlobalValue
 }
 
 // 辅助函数：从User中查找其所属的GlobalValue
-llvm::GlobalValue *BCCommon::findGlobalValueFromUser(llvm::User *U) {
+llvm::GlobalValue *BCCommon::findGlobalValueFromUser(llvm::User *U) const { return findGlobalValueFromUser(U, nullptr); }
+
+/**
+ * @brief 从User中查找其所属的GlobalValue，常量链的结果写入缓存表
+ *
+ * 常量表达式沿第一个user向上查找，链上经过的每个常量都记录同一个结果，
+ * 之后从链上任意位置出发的查询都直接命中。
+ * 惰性模块的use列表会随函数体物化而变化，缓存只能在一批内复用。
+ */
+llvm::GlobalValue *BCCommon::findGlobalValueFromUser(llvm::User *U, ConstantOwnerMemo *memo) const {
     if (!U)
         return nullptr;
 
     // 使用集合记录已访问的User，避免无限递归
-    llvm::DenseSet<llvm::User *> visited;
+    llvm::SmallPtrSet<llvm::User *, 8> visited;
+    llvm::SmallVector<llvm::User *, 8> chain;
+    llvm::GlobalValue *owner = nullptr;
 
     // 递归查找
     while (true) {
         if (!U || !visited.insert(U).second) {
-            return nullptr;
+            break;
         }
 
         // 如果User本身就是GlobalValue
         if (auto *GV = llvm::dyn_cast<llvm::GlobalValue>(U)) {
-            return GV;
+            owner = GV;
+            break;
         }
 
         // 如果User是指令，获取所在的函数
         if (auto *I = llvm::dyn_cast<llvm::Instruction>(U)) {
-            return I->getFunction();
+            owner = I->getFunction();
+            break;
         }
 
-        // 如果User是基本块，获取所在的函数
-        if (auto *BB = llvm::dyn_cast<llvm::BasicBlock>(U)) {
-            return BB->getParent();
+        // 已缓存的常量链
+        if (memo) {
+            auto it = memo->find(U);
+            if (it != memo->end()) {
+                owner = it->second;
+                break;
+            }
         }
+        chain.push_back(U);
 
         // 对于其他User，向上查找其users
         if (U->hasNUses(0)) {
-            return nullptr;
+            break;
         }
 
         // 取第一个user继续查找
         U = *(U->user_begin());
     }
+
+    if (memo) {
+        for (llvm::User *link : chain)
+            memo->try_emplace(link, owner);
+    }
+    return owner;
 }
 
-// 统一的调用关系分析函数
-void BCCommon::analyzeCallRelations() {
-    // 清空现有的调用关系（如果需要重新分析）
-    for (auto &pair : globalValueMap) {
-        pair.second.callers.clear();
-        pair.second.calleds.clear();
-        pair.second.outDegree = 0;
-        pair.second.inDegree = 0;
-        if (pair.second.type == GlobalValueType::FUNCTION) {
-            pair.second.funcSpecific.personalityCalledFunctions.clear();
-            pair.second.funcSpecific.personalityCallerFunctions.clear();
-        }
+// 解析线程数，0表示使用硬件并发数
+unsigned BCCommon::resolveThreadCount(unsigned requested) {
+    if (requested > 0)
+        return requested;
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// 在threadCount个线程上执行taskCount个任务，任务按原子计数器领取
+// 任务的第二个参数是执行它的线程序号（小于threadCount），可用于索引线程私有的缓存
+void BCCommon::runInParallel(size_t taskCount, unsigned threadCount,
+                             const std::function<void(size_t, unsigned)> &task) {
+    unsigned workers = static_cast<unsigned>(std::min<size_t>(threadCount, taskCount));
+    if (workers <= 1) {
+        for (size_t i = 0; i < taskCount; i++)
+            task(i, 0);
+        return;
     }
 
-    // 第一阶段：分析GlobalVariable的初始值
-    for (auto &pair : globalValueMap) {
-        llvm::GlobalValue *GV = pair.first;
-
-        if (auto *GlobalVar = llvm::dyn_cast<llvm::GlobalVariable>(GV)) {
-            GlobalValueInfo &gvInfo = pair.second;
-
-            // 处理全局变量的初始值
-            if (GlobalVar->hasInitializer()) {
-                llvm::Constant *initializer = GlobalVar->getInitializer();
-                llvm::DenseSet<llvm::GlobalValue *> referencedValues;
-
-                // 收集初始值中引用的所有GlobalValue
-                collectGlobalValuesFromConstant(initializer, referencedValues);
-
-                // 记录调用关系
-                for (llvm::GlobalValue *refGV : referencedValues) {
-                    if (refGV != GV && globalValueMap.count(refGV)) {
-                        // GV引用了refGV
-                        gvInfo.calleds.insert(refGV);
-                        GlobalValueInfo &refInfo = globalValueMap[refGV];
-                        refInfo.callers.insert(GV);
-                    }
-                }
-            }
+    std::atomic<size_t> nextTask{0};
+    std::vector<std::thread> threads;
+    threads.reserve(workers);
+    for (unsigned w = 0; w < workers; w++) {
+        threads.emplace_back([&, w]() {
+            for (size_t i = nextTask.fetch_add(1); i < taskCount; i = nextTask.fetch_add(1))
+                task(i, w);
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+/**
+ * @brief 收集单个全局对象相关的调用边
+ *
+ * 只读访问IR和globalValueMap，可在多个线程上并发调用；
+ * 边以符号ID的形式写入调用方提供的缓冲区，由analyzeCallRelations统一构建CSR图。
+ *
+ * @param GV 要分析的全局变量或函数
+ * @param edges 普通调用/引用边 (调用者ID, 被调用者ID)
+ * @param personalityEdges personality边 (函数ID, personality函数ID)
+ * @param scratch 当前线程私有的常量解析缓存
+ */
+void BCCommon::collectCallEdges(llvm::GlobalValue *GV, CallEdgeList &edges, CallEdgeList &personalityEdges,
+                                CallEdgeScratch &scratch) const {
+    // 只记录两端都在globalValueMap中的非自环边
+    auto addEdgeId = [&](SymbolId fromId, SymbolId toId) {
+        if (fromId != InvalidSymbolId && toId != InvalidSymbolId && fromId != toId)
+            edges.emplace_back(fromId, toId);
+    };
+    auto addEdge = [&](llvm::GlobalValue *from, llvm::GlobalValue *to) {
+        if (from && to && from != to)
+            addEdgeId(getSymbolId(from), getSymbolId(to));
+    };
+    // 常量引用经缓存表解析，同一常量只遍历一次；
+    // 常量本身是符号时（不透明指针下的 @p = global ptr @f）直接作为叶子，缓存表只处理复合常量
+    auto addConstantEdges = [&](llvm::GlobalValue *from, llvm::Constant *C) {
+        if (auto *leaf = llvm::dyn_cast<llvm::GlobalValue>(C)) {
+            addEdge(from, leaf);
+            return;
         }
+        if (auto *BA = llvm::dyn_cast<llvm::BlockAddress>(C)) {
+            addEdge(from, BA->getFunction());
+            return;
+        }
+        SymbolId fromId = getSymbolId(from);
+        for (SymbolId refId : resolveConstantReferences(C, scratch.constantRefs, &initializerRefMemo))
+            addEdgeId(fromId, refId);
+    };
+    // 处理调用者（通过uses分析）
+    auto addUserEdges = [&](llvm::GlobalValue *to) {
+        for (llvm::Use &use : to->uses()) {
+            if (llvm::User *U = use.getUser())
+                addEdge(findGlobalValueFromUser(U, &scratch.constantOwners), to);
+        }
+    };
+
+    if (auto *GlobalVar = llvm::dyn_cast<llvm::GlobalVariable>(GV)) {
+        // 收集初始值中引用的所有GlobalValue
+        if (GlobalVar->hasInitializer())
+            addConstantEdges(GlobalVar, GlobalVar->getInitializer());
+        addUserEdges(GlobalVar);
+        return;
     }
 
-    // 第二阶段：分析Function的指令和uses
-    for (auto &pair : globalValueMap) {
-        llvm::GlobalValue *GV = pair.first;
-
-        if (auto *F = llvm::dyn_cast<llvm::Function>(GV)) {
-            GlobalValueInfo &funcInfo = pair.second;
-
-            // 1. 处理personality函数（异常处理函数）
-            if (F->hasPersonalityFn()) {
-                if (auto *personality = F->getPersonalityFn()) {
-                    if (auto *personalityF = llvm::dyn_cast<llvm::Function>(personality)) {
-                        if (globalValueMap.count(personalityF)) {
-                            // 记录personality符号调用关系
-                            funcInfo.funcSpecific.personalityCalledFunctions.insert(personalityF);
-                            GlobalValueInfo &personalityInfo = globalValueMap[personalityF];
-                            personalityInfo.funcSpecific.personalityCallerFunctions.insert(F);
-
-                            // 同时也记录到普通的调用关系中
-                            funcInfo.calleds.insert(personalityF);
-                            personalityInfo.callers.insert(F);
-                        }
-                    }
-                }
-            }
+    auto *F = llvm::dyn_cast<llvm::Function>(GV);
+    if (!F)
+        return;
 
-            // 跳过声明（只有函数体才需要分析）
-            if (F->isDeclaration()) {
-                continue;
+    // 1. 处理personality函数（异常处理函数），同时也记录到普通的调用关系中
+    if (F->hasPersonalityFn()) {
+        if (auto *personalityF = llvm::dyn_cast<llvm::Function>(F->getPersonalityFn())) {
+            SymbolId personalityId = getSymbolId(personalityF);
+            if (personalityF != F && personalityId != InvalidSymbolId) {
+                personalityEdges.emplace_back(getSymbolId(F), personalityId);
+                addEdge(F, personalityF);
             }
+        }
+    }
+
+    // 跳过声明（只有函数体才需要分析）
+    if (F->isDeclaration() || F->isMaterializable())
+        return;
 
-            // 2. 处理被调用者（函数体中的指令）
-            for (llvm::BasicBlock &BB : *F) {
-                for (llvm::Instruction &I : BB) {
-                    // 处理直接调用
-                    if (auto *callInst = llvm::dyn_cast<llvm::CallInst>(&I)) {
-                        llvm::Value *calledValue = callInst->getCalledOperand();
-                        if (!calledValue)
-                            continue;
-
-                        calledValue = calledValue->stripPointerCasts();
-                        if (auto *calledF = llvm::dyn_cast<llvm::Function>(calledValue)) {
-                            if (calledF != F && globalValueMap.count(calledF)) {
-                                funcInfo.calleds.insert(calledF);
-                                GlobalValueInfo &calledInfo = globalValueMap[calledF];
-                                calledInfo.callers.insert(F);
-                            }
-                        }
-                    }
-                    // 处理调用指令的变体（如InvokeInst）
-                    else if (auto *invokeInst = llvm::dyn_cast<llvm::InvokeInst>(&I)) {
-                        llvm::Value *calledValue = invokeInst->getCalledOperand();
-                        if (!calledValue)
-                            continue;
-
-                        calledValue = calledValue->stripPointerCasts();
-                        if (auto *calledF = llvm::dyn_cast<llvm::Function>(calledValue)) {
-                            if (calledF != F && globalValueMap.count(calledF)) {
-                                funcInfo.calleds.insert(calledF);
-                                GlobalValueInfo &calledInfo = globalValueMap[calledF];
-                                calledInfo.callers.insert(F);
-                            }
-                        }
-                    }
-                    // 处理间接调用（通过函数指针）
-                    else if (auto *loadInst = llvm::dyn_cast<llvm::LoadInst>(&I)) {
-                        llvm::Value *addr = loadInst->getPointerOperand();
-                        addr = addr->stripPointerCasts();
-
-                        // 如果是全局变量，检查其初始值中是否有函数
-                        if (auto *globalVar = llvm::dyn_cast<llvm::GlobalVariable>(addr)) {
-                            if (globalVar->hasInitializer()) {
-                                llvm::Constant *init = globalVar->getInitializer();
-                                llvm::DenseSet<llvm::GlobalValue *> referencedValues;
-                                collectGlobalValuesFromConstant(init, referencedValues);
-
-                                for (llvm::GlobalValue *refGV : referencedValues) {
-                                    if (refGV != F && globalValueMap.count(refGV)) {
-                                        funcInfo.calleds.insert(refGV);
-                                        GlobalValueInfo &refInfo = globalValueMap[refGV];
-                                        refInfo.callers.insert(F);
-                                    }
-                                }
-                            }
-                        }
-                    }
-                    // 处理其他可能引用GlobalValue的指令
-                    else {
-                        // 遍历指令的所有操作数
-                        for (unsigned i = 0; i < I.getNumOperands(); i++) {
-                            llvm::Value *operand = I.getOperand(i);
-                            if (!operand)
-                                continue;
-
-                            operand = operand->stripPointerCasts();
-
-                            // 如果是GlobalValue
-                            if (auto *globalVal = llvm::dyn_cast<llvm::GlobalValue>(operand)) {
-                                if (globalVal != F && globalValueMap.count(globalVal)) {
-                                    funcInfo.calleds.insert(globalVal);
-                                    GlobalValueInfo &opInfo = globalValueMap[globalVal];
-                                    opInfo.callers.insert(F);
-                                }
-                            }
-                            // 如果是常量，检查其中是否包含GlobalValue
-                            else if (auto *constant = llvm::dyn_cast<llvm::Constant>(operand)) {
-                                llvm::DenseSet<llvm::GlobalValue *> referencedValues;
-                                collectGlobalValuesFromConstant(constant, referencedValues);
-
-                                for (llvm::GlobalValue *refGV : referencedValues) {
-                                    if (refGV != F && globalValueMap.count(refGV)) {
-                                        funcInfo.calleds.insert(refGV);
-                                        GlobalValueInfo &refInfo = globalValueMap[refGV];
-                                        refInfo.callers.insert(F);
-                                    }
-                                }
-                            }
-                        }
-                    }
+    // 2. 处理被调用者（函数体中的指令）
+    for (llvm::BasicBlock &BB : *F) {
+        for (llvm::Instruction &I : BB) {
+            // 处理直接调用及其变体（如InvokeInst）
+            if (auto *call = llvm::dyn_cast<llvm::CallBase>(&I)) {
+                if (llvm::Value *calledValue = call->getCalledOperand()) {
+                    if (auto *calledF = llvm::dyn_cast<llvm::Function>(calledValue->stripPointerCasts()))
+                        addEdge(F, calledF);
                 }
             }
-
-            // 3. 处理调用者（通过uses分析）
-            llvm::SmallVector<llvm::User *, 32> users;
-            for (llvm::Use &use : F->uses()) {
-                if (llvm::User *U = use.getUser()) {
-                    users.push_back(U);
+            // 处理间接调用（通过函数指针）：全局变量初始值中的函数
+            else if (auto *loadInst = llvm::dyn_cast<llvm::LoadInst>(&I)) {
+                llvm::Value *addr = loadInst->getPointerOperand()->stripPointerCasts();
+                if (auto *globalVar = llvm::dyn_cast<llvm::GlobalVariable>(addr)) {
+                    if (globalVar->hasInitializer())
+                        addConstantEdges(F, globalVar->getInitializer());
                 }
             }
 
-            for (llvm::User *U : users) {
-                llvm::GlobalValue *callerGV = findGlobalValueFromUser(U);
-                if (callerGV && callerGV != F && globalValueMap.count(callerGV)) {
-                    // 记录调用关系
-                    funcInfo.callers.insert(callerGV);
-                    GlobalValueInfo &callerInfo = globalValueMap[callerGV];
-                    callerInfo.calleds.insert(F);
+            // 处理指令操作数中引用的GlobalValue
+            // 惰性模块中其他函数体未物化，use列表不完整，这里需要覆盖所有指令的操作数
+            for (unsigned i = 0; i < I.getNumOperands(); i++) {
+                llvm::Value *operand = I.getOperand(i);
+                if (!operand)
+                    continue;
+
+                operand = operand->stripPointerCasts();
+                if (auto *globalVal = llvm::dyn_cast<llvm::GlobalValue>(operand)) {
+                    addEdge(F, globalVal);
+                } else if (auto *constant = llvm::dyn_cast<llvm::Constant>(operand)) {
+                    addConstantEdges(F, constant);
                 }
             }
         }
     }
 
-    // 第三阶段：处理GlobalVariable的uses（调用者）
+    // 3. 处理调用者（通过uses分析）
+    addUserEdges(F);
+}
+
+/**
+ * @brief 统一的调用关系分析函数
+ *
+ * 按Config::callGraphEngine选择边的来源：IR分析扫描每条指令，摘要分析读取ModuleSummaryIndex
+ * 中的调用和引用列表。两者得到的边都以符号ID表示，一次性构建正反两个方向的CSR调用图。
+ * 摘要不可用时退回IR分析；crossCheckCallGraph打开时两种都运行并记录差异，使用所选引擎的结果。
+ * 输入内容和符号表与上次相同时，直接从分析缓存读取边和指令数。
+ */
+void BCCommon::analyzeCallRelations() {
+    // 清空现有的调用关系（如果需要重新分析）
+    callGraph.clear();
+    personalityGraph.clear();
     for (auto &pair : globalValueMap) {
-        llvm::GlobalValue *GV = pair.first;
+        pair.second.outDegree = 0;
+        pair.second.inDegree = 0;
+    }
 
-        if (auto *GlobalVar = llvm::dyn_cast<llvm::GlobalVariable>(GV)) {
-            GlobalValueInfo &gvInfo = pair.second;
+    if (!module)
+        return;
 
-            // 处理所有uses
-            llvm::SmallVector<llvm::User *, 32> users;
-            for (llvm::Use &use : GlobalVar->uses()) {
-                if (llvm::User *U = use.getUser()) {
-                    users.push_back(U);
-                }
-            }
+    // 符号ID按模块顺序分配，工作项即符号表本身，合并顺序确定
+    if (symbols.size() != globalValueMap.size())
+        assignSymbolIds();
+
+    // 交叉检查需要真正运行两种分析，不读写缓存
+    AnalysisCache cache(config.workSpace + "cache/");
+    AnalysisCacheKey cacheKey = makeAnalysisCacheKey();
+    bool useCache = config.analysisCache && inputHash != 0 && !config.crossCheckCallGraph;
+    AnalysisSnapshot snapshot;
+    std::string cacheError;
+    bool cached = useCache && cache.load(cacheKey, snapshot, cacheError);
+
+    CallEdgeList allEdges;
+    CallEdgeList allPersonalityEdges;
+    std::string source = "缓存";
+    if (cached) {
+        allEdges = std::move(snapshot.callEdges);
+        allPersonalityEdges = std::move(snapshot.personalityEdges);
+        instructionCounts = std::move(snapshot.instructionCounts);
+        logger.log("命中分析缓存: " + cache.getPath(cacheKey));
+    } else {
+        if (useCache)
+            logger.logToFile("分析缓存未命中(" + cacheError + ")，重新分析调用关系");
+        source = collectEdges(allEdges, allPersonalityEdges) ? "摘要" : "IR";
+    }
 
-            for (llvm::User *U : users) {
-                llvm::GlobalValue *callerGV = findGlobalValueFromUser(U);
-                if (callerGV && callerGV != GV && globalValueMap.count(callerGV)) {
-                    // 记录调用关系
-                    gvInfo.callers.insert(callerGV);
-                    GlobalValueInfo &callerInfo = globalValueMap[callerGV];
-                    callerInfo.calleds.insert(GV);
-                }
+    size_t rawEdgeCount = allEdges.size();
+    callGraph.build(symbols.size(), allEdges);
+    personalityGraph.build(symbols.size(), allPersonalityEdges);
+
+    // 计算入度和出度
+    for (SymbolId id = 0; id < symbolInfos.size(); id++) {
+        symbolInfos[id]->inDegree = callGraph.inDegree(id);
+        symbolInfos[id]->outDegree = callGraph.outDegree(id);
+    }
+
+    logger.logToFile("调用关系分析完成(" + source + "): " + std::to_string(symbols.size()) + " 个全局对象, " +
+                     std::to_string(rawEdgeCount) + " 条原始边, " + std::to_string(callGraph.getEdgeCount()) +
+                     " 条去重边");
+
+    if (useCache && !cached) {
+        // build之后边列表已排序去重
+        snapshot.callEdges = std::move(allEdges);
+        snapshot.personalityEdges = std::move(allPersonalityEdges);
+        snapshot.instructionCounts = instructionCounts;
+        if (cache.store(cacheKey, snapshot, cacheError))
+            logger.logToFile("分析结果已写入缓存: " + cache.getPath(cacheKey));
+        else
+            logger.logWarning("无法写入分析缓存: " + cacheError);
+    }
+}
+
+/**
+ * @brief 按所选引擎收集调用边和指令数
+ *
+ * @return 使用的是摘要分析时返回true
+ */
+bool BCCommon::collectEdges(CallEdgeList &allEdges, CallEdgeList &allPersonalityEdges) {
+    if (config.callGraphEngine == CallGraphEngine::Summary) {
+        if (collectSummaryEdges(allEdges, allPersonalityEdges)) {
+            if (config.crossCheckCallGraph) {
+                // 指令数以摘要为准，IR分析只用于对比
+                std::vector<uint32_t> summaryInstructionCounts = instructionCounts;
+                CallEdgeList irEdges;
+                CallEdgeList irPersonalityEdges;
+                collectIREdges(irEdges, irPersonalityEdges);
+                crossCheckEdges(allEdges, irEdges, summaryInstructionCounts);
+                instructionCounts = std::move(summaryInstructionCounts);
             }
+            return true;
         }
+        logger.logWarning("摘要分析不可用，改用IR分析调用关系");
+        allEdges.clear();
+        allPersonalityEdges.clear();
     }
 
-    // 第四阶段：计算入度和出度
-    for (auto &pair : globalValueMap) {
-        GlobalValueInfo &info = pair.second;
-        info.inDegree = info.callers.size();
-        info.outDegree = info.calleds.size();
+    collectIREdges(allEdges, allPersonalityEdges);
+    return false;
+}
+
+// 缓存键：输入内容哈希、按ID顺序的符号名、分析引擎和调用边提取规则的版本
+AnalysisCacheKey BCCommon::makeAnalysisCacheKey() const {
+    std::vector<llvm::StringRef> names;
+    names.reserve(symbols.size());
+    for (const llvm::GlobalValue *GV : symbols) {
+        names.push_back(GV->getName());
     }
 
-    // 第五阶段：验证和清理（可选）
-    // 确保调用关系的对称性
-    for (auto &pair : globalValueMap) {
-        llvm::GlobalValue *GV = pair.first;
-        GlobalValueInfo &info = pair.second;
-
-        // 检查所有callers中的GV是否确实将当前GV作为called
-        for (llvm::GlobalValue *caller : info.callers) {
-            if (globalValueMap.count(caller)) {
-                auto &callerInfo = globalValueMap[caller];
-                if (!callerInfo.calleds.count(GV)) {
-                    // 修复不对称的调用关系
-                    callerInfo.calleds.insert(GV);
-                    callerInfo.outDegree = callerInfo.calleds.size();
-                }
-            }
+    AnalysisCacheKey key;
+    key.inputHash = inputHash;
+    key.symbolHash = AnalysisCache::hashNames(names);
+    key.symbolCount = static_cast<uint32_t>(symbols.size());
+    key.engine = static_cast<uint32_t>(config.callGraphEngine);
+    key.rulesVersion = CallEdgeRulesVersion;
+    return key;
+}
+
+/**
+ * @brief 扫描IR得到调用边
+ *
+ * 按符号ID顺序把全局对象切成固定大小的块，在线程池上并行扫描，每块写入独立的边缓冲区，
+ * 之后按块顺序拼接。惰性模块按批物化函数体：主线程物化一批、并行扫描、再丢弃该批函数体。
+ */
+void BCCommon::collectIREdges(CallEdgeList &allEdges, CallEdgeList &allPersonalityEdges) {
+    bool hasLazyBodies = false;
+    for (llvm::GlobalValue *GV : symbols) {
+        hasLazyBodies |= GV->isMaterializable();
+    }
+
+    // 全局变量初始值只解析一次，并行阶段只读共享
+    precomputeInitializerReferences();
+    instructionCounts.assign(symbols.size(), 0);
+
+    const unsigned threadCount = resolveThreadCount(config.analysisThreads);
+    std::vector<CallEdgeScratch> workerScratch(threadCount);
+    const size_t chunkSize = 256;
+    // 惰性模块每批最多常驻这么多函数体；完整加载的模块一批处理完
+    const size_t batchSize = hasLazyBodies ? 4096 : std::max<size_t>(symbols.size(), 1);
+
+    for (size_t batchBegin = 0; batchBegin < symbols.size(); batchBegin += batchSize) {
+        size_t batchEnd = std::min(batchBegin + batchSize, symbols.size());
+
+        // 物化不是线程安全的，由主线程完成
+        llvm::SmallVector<llvm::Function *, 32> materialized;
+        for (size_t i = batchBegin; i < batchEnd; i++) {
+            auto *F = llvm::dyn_cast<llvm::Function>(symbols[i]);
+            if (F && F->isMaterializable() && materializeFunction(*F))
+                materialized.push_back(F);
         }
 
-        // 检查所有calleds中的GV是否确实将当前GV作为caller
-        for (llvm::GlobalValue *called : info.calleds) {
-            if (globalValueMap.count(called)) {
-                auto &calledInfo = globalValueMap[called];
-                if (!calledInfo.callers.count(GV)) {
-                    // 修复不对称的调用关系
-                    calledInfo.callers.insert(GV);
-                    calledInfo.inDegree = calledInfo.callers.size();
-                }
+        size_t chunkCount = (batchEnd - batchBegin + chunkSize - 1) / chunkSize;
+        std::vector<CallEdgeList> chunkEdges(chunkCount);
+        std::vector<CallEdgeList> chunkPersonalityEdges(chunkCount);
+        // use列表随物化变化，常量所属对象的缓存只在本批内有效
+        for (CallEdgeScratch &scratch : workerScratch) {
+            scratch.constantOwners.clear();
+        }
+        runInParallel(chunkCount, threadCount, [&](size_t chunk, unsigned worker) {
+            size_t begin = batchBegin + chunk * chunkSize;
+            size_t end = std::min(begin + chunkSize, batchEnd);
+            for (size_t i = begin; i < end; i++) {
+                collectCallEdges(symbols[i], chunkEdges[chunk], chunkPersonalityEdges[chunk], workerScratch[worker]);
+                // 函数体只在这一批内常驻，顺便记录指令数
+                if (auto *F = llvm::dyn_cast<llvm::Function>(symbols[i]))
+                    instructionCounts[i] = F->getInstructionCount();
             }
+        });
+
+        for (llvm::Function *F : materialized) {
+            dematerializeFunction(*F);
+        }
+
+        // 按块顺序拼接
+        for (size_t chunk = 0; chunk < chunkCount; chunk++) {
+            allEdges.insert(allEdges.end(), chunkEdges[chunk].begin(), chunkEdges[chunk].end());
+            allPersonalityEdges.insert(allPersonalityEdges.end(), chunkPersonalityEdges[chunk].begin(),
+                                       chunkPersonalityEdges[chunk].end());
         }
     }
+
+    size_t memoizedConstants = initializerRefMemo.size();
+    for (const CallEdgeScratch &scratch : workerScratch) {
+        memoizedConstants += scratch.constantRefs.size();
+    }
+    initializerRefMemo.clear();
+
+    logger.logToFile("IR调用关系扫描: " + std::to_string(allEdges.size()) + " 条原始边, " +
+                     std::to_string(memoizedConstants) + " 个缓存常量, " + std::to_string(threadCount) + " 个线程");
 }
 
-void GlobalValueNameMatcher::rebuildCache(const llvm::DenseMap<llvm::GlobalValue *, GlobalValueInfo> &globalValueMap) {
-    std::lock_guard<std::mutex> lock(cacheMutex);
+/**
+ * @brief 从ModuleSummaryIndex得到调用边
+ *
+ * 输入带嵌入摘要时不物化任何函数体。没有摘要时只对已完整加载的模块现场构建；
+ * 惰性加载的模块构建摘要需要同时物化全部函数体，峰值内存反而高于分批的IR分析，此时退回IR分析。
+ * personality在模块级解析，直接从函数头读取。
+ *
+ * @return 摘要不可用时返回false
+ */
+bool BCCommon::collectSummaryEdges(CallEdgeList &allEdges, CallEdgeList &allPersonalityEdges) {
+    std::unique_ptr<llvm::ModuleSummaryIndex> index;
+    if (inputBuffer) {
+        std::string error;
+        index = SummaryCallGraphSource::readEmbeddedIndex(inputBuffer->getMemBufferRef(), error);
+        if (!error.empty())
+            logger.logWarning("读取嵌入摘要失败: " + error);
+        if (index)
+            logger.log("使用输入中嵌入的模块摘要分析调用关系");
+    }
 
-    nameCache.clear();
-    for (const auto &[F, info] : globalValueMap) {
-        if (!info.displayName.empty()) {
-            nameCache.insert({info.displayName, F});
+    if (!index) {
+        bool lazy = llvm::any_of(*module, [](const llvm::Function &F) { return F.isMaterializable(); });
+        if (lazy) {
+            logger.logWarning("输入没有嵌入摘要，构建摘要需要一次物化全部函数体，不如分批的IR分析省内存");
+            return false;
         }
+        logger.log("输入没有嵌入摘要，在已加载的模块上构建模块摘要");
+        index = SummaryCallGraphSource::buildIndex(*module);
+        if (!index)
+            return false;
+    }
+
+    instructionCounts.assign(symbols.size(), 0);
+    SummaryEdgeStats stats = SummaryCallGraphSource::collectEdges(*index, symbols, allEdges, instructionCounts);
+
+    // personality边同时记入普通调用关系，与IR分析一致
+    for (SymbolId id = 0; id < symbols.size(); id++) {
+        auto *F = llvm::dyn_cast<llvm::Function>(symbols[id]);
+        if (!F || !F->hasPersonalityFn())
+            continue;
+        auto *personalityF = llvm::dyn_cast<llvm::Function>(F->getPersonalityFn());
+        SymbolId personalityId = personalityF ? getSymbolId(personalityF) : InvalidSymbolId;
+        if (personalityId == InvalidSymbolId || personalityId == id)
+            continue;
+        allPersonalityEdges.emplace_back(id, personalityId);
+        allEdges.emplace_back(id, personalityId);
     }
-    if (globalValueMap.size() > 100)
-        cacheValid = true;
-}
 
-void GlobalValueNameMatcher::invalidateCache() {
-    std::lock_guard<std::mutex> lock(cacheMutex);
-    cacheValid = false;
+    logger.logToFile("摘要调用关系: " + std::to_string(stats.callEdges) + " 条调用边(其中 " +
+                     std::to_string(stats.hotCallEdges) + " 条热边), " + std::to_string(stats.refEdges) +
+                     " 条引用边, " + std::to_string(allPersonalityEdges.size()) + " 条personality边, " +
+                     std::to_string(stats.missingSummaries) + " 个符号没有摘要");
+    return true;
 }
 
-bool GlobalValueNameMatcher::containsGlobalValueName(llvm::StringRef str) {
-    std::lock_guard<std::mutex> lock(cacheMutex);
+/**
+ * @brief 对比摘要分析与IR分析得到的边和指令数，差异写入日志
+ *
+ * IR分析会把通过全局变量加载的函数指针直接连到加载者，摘要中只有到全局变量的引用，
+ * 因此IR独有的边中有一部分只是摘要中两跳路径的捷径。
+ */
+void BCCommon::crossCheckEdges(const CallEdgeList &summaryEdges, const CallEdgeList &irEdges,
+                               llvm::ArrayRef<uint32_t> summaryInstructionCounts) {
+    auto normalize = [](const CallEdgeList &edges) {
+        CallEdgeList sorted = edges;
+        llvm::sort(sorted);
+        sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+        return sorted;
+    };
+    CallEdgeList summarySet = normalize(summaryEdges);
+    CallEdgeList irSet = normalize(irEdges);
+
+    CallEdgeList summaryOnly;
+    CallEdgeList irOnly;
+    std::set_difference(summarySet.begin(), summarySet.end(), irSet.begin(), irSet.end(),
+                        std::back_inserter(summaryOnly));
+    std::set_difference(irSet.begin(), irSet.end(), summarySet.begin(), summarySet.end(), std::back_inserter(irOnly));
+
+    size_t countMismatches = 0;
+    for (SymbolId id = 0; id < symbols.size(); id++) {
+        if (summaryInstructionCounts[id] != instructionCounts[id])
+            countMismatches++;
+    }
 
-    if (!cacheValid || nameCache.empty()) {
-        return false;
+    logger.log("调用图交叉检查: 摘要 " + std::to_string(summarySet.size()) + " 条边, IR " +
+               std::to_string(irSet.size()) + " 条边, 摘要独有 " + std::to_string(summaryOnly.size()) + ", IR独有 " +
+               std::to_string(irOnly.size()) + ", 指令数不一致 " + std::to_string(countMismatches) + " 个符号");
+
+    const size_t sampleLimit = 20;
+    auto logSamples = [&](llvm::StringRef title, const CallEdgeList &edges) {
+        for (size_t i = 0; i < edges.size() && i < sampleLimit; i++) {
+            logger.logToFile("  " + title.str() + ": " + symbolInfos[edges[i].first]->displayName + " -> " +
+                             symbolInfos[edges[i].second]->displayName);
+        }
+    };
+    logSamples("摘要独有", summaryOnly);
+    logSamples("IR独有", irOnly);
+}
+
+/**
+ * @brief 预测生成一个分组时的内存占用（字节）
+ *
+ * 包括两部分：在独立上下文中惰性加载的源模块（全局对象、初始值，不含函数体），
+ * 以及抽取出的分组模块（组内函数体、组内全局对象和引用到的组外声明）在优化期间的峰值。
+ * 系数按64位平台上IR对象的典型大小取整，只用于调度时的相对比较和准入控制。
+ */
+size_t BCCommon::predictEmissionFootprint(llvm::ArrayRef<SymbolId> group) const {
+    // 每条指令：Instruction对象、操作数Use和元数据附件
+    constexpr size_t bytesPerInstruction = 160;
+    // 每个全局对象：GlobalValue对象、符号表项和初始值常量
+    constexpr size_t bytesPerGlobal = 256;
+    // O2期间分析结果和临时IR相对于分组模块本身的放大倍数
+    constexpr size_t optimizationFactor = 3;
+
+    size_t moduleGlobals = 0;
+    if (module)
+        moduleGlobals = module->global_size() + module->size() + module->alias_size() + module->ifunc_size();
+
+    size_t instructions = 0;
+    size_t globals = 0;
+    for (SymbolId id : group) {
+        instructions += instructionCounts.empty() ? 0 : instructionCounts[id];
+        // 组内定义本身加上它引用的组外符号声明（上界）
+        globals += 1 + callGraph.outDegree(id);
     }
 
-    for (const auto &entry : nameCache) {
-        llvm::StringRef key = entry.getKey();
-        if (str.find(key) != llvm::StringRef::npos) {
-            return true;
+    size_t sourceBytes = moduleGlobals * bytesPerGlobal;
+    size_t groupBytes = (instructions * bytesPerInstruction + globals * bytesPerGlobal) * optimizationFactor;
+    return sourceBytes + groupBytes;
+}
+
+void GlobalValueNameMatcher::rebuildCache(const llvm::DenseMap<llvm::GlobalValue *, GlobalValueInfo> &globalValueMap) {
+    auto newIndex = std::make_shared<NameIndex>();
+
+    for (const auto &[F, info] : globalValueMap) {
+        if (info.displayName.empty())
+            continue;
+
+        // 重复的名字保留第一次出现的对象
+        uint32_t patternId = newIndex->automaton.addPattern(info.displayName);
+        if (patternId == newIndex->names.size()) {
+            newIndex->names.push_back(info.displayName);
+            newIndex->values.push_back(F);
         }
     }
-    return false;
+    newIndex->automaton.build();
+
+    std::atomic_store(&index, std::shared_ptr<const NameIndex>(std::move(newIndex)));
 }
 
-llvm::StringMap<llvm::GlobalValue *> GlobalValueNameMatcher::getMatchingGlobalValues(llvm::StringRef str) {
-    std::lock_guard<std::mutex> lock(cacheMutex);
-    llvm::StringMap<llvm::GlobalValue *> results;
+void GlobalValueNameMatcher::invalidateCache() { std::atomic_store(&index, std::shared_ptr<const NameIndex>()); }
 
-    if (!cacheValid || nameCache.empty()) {
-        return results;
+size_t GlobalValueNameMatcher::getCacheSize() const {
+    auto current = snapshot();
+    return current ? current->names.size() : 0;
+}
+
+bool GlobalValueNameMatcher::containsGlobalValueName(llvm::StringRef str) const {
+    auto current = snapshot();
+    if (!current) {
+        return false;
     }
+    return current->automaton.containsAny(str);
+}
 
-    for (const auto &entry : nameCache) {
-        llvm::StringRef key = entry.getKey();
-        llvm::GlobalValue *value = entry.getValue();
-        if (str.find(key) != llvm::StringRef::npos) {
-            results[key] = value;
-        }
+llvm::StringMap<llvm::GlobalValue *> GlobalValueNameMatcher::getMatchingGlobalValues(llvm::StringRef str) const {
+    llvm::StringMap<llvm::GlobalValue *> results;
+    auto current = snapshot();
+    if (!current) {
+        return results;
     }
+
+    current->automaton.forEachMatch(str, [&](uint32_t patternId, size_t) {
+        results.try_emplace(current->names[patternId], current->values[patternId]);
+        return true;
+    });
     return results;
 }
 
+llvm::GlobalValue *GlobalValueNameMatcher::getFirstMatchingGlobalValue(llvm::StringRef str) const {
+    auto current = snapshot();
+    if (!current) {
+        return nullptr;
+    }
+
+    llvm::GlobalValue *result = nullptr;
+    current->automaton.forEachMatch(str, [&](uint32_t patternId, size_t) {
+        result = current->values[patternId];
+        return false;
+    });
+    return result;
+}
+
 bool BCCommon::matchesPattern(llvm::StringRef filename, llvm::StringRef pattern) {
     if (pattern.empty() || filename.empty()) {
         return false;
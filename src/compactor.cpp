@@ -0,0 +1,112 @@
+// compactor.cpp
+#include "compactor.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/Comdat.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/PassManager.h"
+#include "llvm/Transforms/IPO/StripSymbols.h"
+
+std::string CompactionStats::getSummary() const {
+    return "删除 " + std::to_string(declarations) + " 个无引用声明, " + std::to_string(comdats) + " 个空comdat, " +
+           std::to_string(namedMetadata) + " 个空命名元数据, 丢弃 " + std::to_string(localNames) + " 个局部名字" +
+           (debugInfoPruned ? ", 已清理无效调试信息" : "");
+}
+
+CompactionStats ModuleCompactor::run(llvm::Module &M) const {
+    CompactionStats stats;
+    if (options.discardLocalNames)
+        stats.localNames = discardLocalNames(M);
+    if (options.pruneDeclarations)
+        stats.declarations = pruneDeclarations(M);
+    // 声明删除后comdat和调试信息才可能变成无主的
+    stats.comdats = pruneComdats(M);
+    if (options.pruneDebugInfo)
+        stats.debugInfoPruned = pruneDebugInfo(M);
+    stats.namedMetadata = pruneNamedMetadata(M);
+    return stats;
+}
+
+// 删除没有任何引用的函数和全局变量声明；只被死常量表达式引用的也算无引用
+size_t ModuleCompactor::pruneDeclarations(llvm::Module &M) {
+    llvm::SmallVector<llvm::GlobalValue *, 64> dead;
+    for (llvm::Function &F : M) {
+        if (!F.isDeclaration())
+            continue;
+        F.removeDeadConstantUsers();
+        if (F.use_empty())
+            dead.push_back(&F);
+    }
+    for (llvm::GlobalVariable &GVar : M.globals()) {
+        if (!GVar.isDeclaration())
+            continue;
+        GVar.removeDeadConstantUsers();
+        if (GVar.use_empty())
+            dead.push_back(&GVar);
+    }
+
+    for (llvm::GlobalValue *GV : dead) {
+        GV->eraseFromParent();
+    }
+    return dead.size();
+}
+
+// 删除没有成员的comdat
+size_t ModuleCompactor::pruneComdats(llvm::Module &M) {
+    llvm::SmallVector<llvm::StringRef, 16> unused;
+    for (auto &entry : M.getComdatSymbolTable()) {
+        if (entry.second.getUsers().empty())
+            unused.push_back(entry.first());
+    }
+    for (llvm::StringRef name : unused) {
+        M.getComdatSymbolTable().erase(name);
+    }
+    return unused.size();
+}
+
+// 删除没有操作数的命名元数据
+size_t ModuleCompactor::pruneNamedMetadata(llvm::Module &M) {
+    llvm::SmallVector<llvm::NamedMDNode *, 8> empty;
+    for (llvm::NamedMDNode &NMD : M.named_metadata()) {
+        if (NMD.getNumOperands() == 0)
+            empty.push_back(&NMD);
+    }
+    for (llvm::NamedMDNode *NMD : empty) {
+        M.eraseNamedMetadata(NMD);
+    }
+    return empty.size();
+}
+
+// 从编译单元中去掉已不在本模块中的全局变量等调试信息
+bool ModuleCompactor::pruneDebugInfo(llvm::Module &M) {
+    if (!M.getNamedMetadata("llvm.dbg.cu"))
+        return false;
+    // StripDeadDebugInfoPass不查询分析结果，空的分析管理器即可
+    llvm::ModuleAnalysisManager MAM;
+    llvm::StripDeadDebugInfoPass().run(M, MAM);
+    return true;
+}
+
+// 丢弃参数、基本块和指令的名字，这些名字只用于阅读IR
+size_t ModuleCompactor::discardLocalNames(llvm::Module &M) {
+    size_t count = 0;
+    auto discard = [&](llvm::Value &V) {
+        if (V.hasName()) {
+            V.setName("");
+            count++;
+        }
+    };
+
+    for (llvm::Function &F : M) {
+        for (llvm::Argument &arg : F.args()) {
+            discard(arg);
+        }
+        for (llvm::BasicBlock &BB : F) {
+            discard(BB);
+            for (llvm::Instruction &I : BB) {
+                discard(I);
+            }
+        }
+    }
+    return count;
+}
@@ -264,7 +264,8 @@ void GlobalValueInfo::updateAttributesFromLLVM() {
     }
 }
 
-std::string GlobalValueInfo::getFullInfo() const {
+std::string GlobalValueInfo::getFullInfo(const CallGraph &callGraph, const CallGraph &personalityGraph,
+                                         llvm::ArrayRef<llvm::GlobalValue *> symbols) const {
     std::stringstream ss;
 
     // 基本信息部分
@@ -301,23 +302,29 @@ std::string GlobalValueInfo::getFullInfo() const {
     ss << "\n--- 调用关系 ---\n";
     ss << "入度: " << inDegree << ", ";
     ss << "出度: " << outDegree << "\n";
+    if (symbolId == InvalidSymbolId) {
+        return ss.str();
+    }
+    llvm::ArrayRef<SymbolId> callers = callGraph.callers(symbolId);
+    llvm::ArrayRef<SymbolId> calleds = callGraph.calleds(symbolId);
     ss << "调用者数量: " << callers.size() << "\n";
     if (callers.size() < 10) {
-        for (const auto *caller : callers) {
-            ss << "  -- " << caller->getName().str() << "\n";
+        for (SymbolId caller : callers) {
+            ss << "  -- " << symbols[caller]->getName().str() << "\n";
         }
     }
     ss << "被调用者数量: " << calleds.size() << "\n";
     if (calleds.size() < 10) {
-        for (const auto *called : calleds) {
-            ss << "  -- " << called->getName().str() << "\n";
+        for (SymbolId called : calleds) {
+            ss << "  -- " << symbols[called]->getName().str() << "\n";
         }
     }
     if (type == GlobalValueType::FUNCTION) {
-        ss << "个性符号数量: " << funcSpecific.personalityCalledFunctions.size() << "\n";
-        if (funcSpecific.personalityCalledFunctions.size() < 10) {
-            for (const auto *personalityCalledFunction : funcSpecific.personalityCalledFunctions) {
-                ss << "  -- " << personalityCalledFunction->getName().str() << "\n";
+        llvm::ArrayRef<SymbolId> personalityCalleds = personalityGraph.calleds(symbolId);
+        ss << "个性符号数量: " << personalityCalleds.size() << "\n";
+        if (personalityCalleds.size() < 10) {
+            for (SymbolId personalityCalled : personalityCalleds) {
+                ss << "  -- " << symbols[personalityCalled]->getName().str() << "\n";
             }
         }
     }
@@ -360,115 +367,3 @@ std::string GlobalValueInfo::getBriefInfo() const {
 
     return ss.str();
 }
-
-/**
- * 判断指定符号的调用者是否全部在指定的组中
- *
- * @param GV 要检查的符号，该符号必须在group和globalValueMap中
- * @param group 符号组
- * @param globalValueMap 符号信息映射表
- * @return true 如果GV的所有调用者都在group中
- * @return false 如果GV有调用者不在group中
- * @throws std::invalid_argument 如果GV不在globalValueMap中
- */
-bool GlobalValueInfo::areAllCallersInGroup(llvm::GlobalValue *GV, const llvm::DenseSet<llvm::GlobalValue *> &group,
-                                           const llvm::DenseMap<llvm::GlobalValue *, GlobalValueInfo> &globalValueMap) {
-    // 参数检查
-    if (group.find(GV) == group.end()) {
-        throw std::invalid_argument("GlobalValue must be in the group");
-    }
-
-    auto infoIt = globalValueMap.find(GV);
-    if (infoIt == globalValueMap.end()) {
-        throw std::invalid_argument("GlobalValue must be in globalValueMap");
-    }
-
-    const auto &callers = infoIt->second.callers;
-
-    // 如果符号没有调用者，那么所有调用者（没有）都在group中
-    if (callers.empty()) {
-        return true;
-    }
-
-    // 获取当前符号的 isProcessed 状态
-    bool currentGVProcessed = infoIt->second.isProcessed;
-
-    // 检查每个调用者是否都在group中，并检查 isProcessed 状态
-    for (llvm::GlobalValue *caller : callers) {
-        // 检查调用者是否在group中
-        if (group.find(caller) == group.end()) {
-            return false; // 发现一个不在group中的调用者
-        }
-
-        // 检查调用者的 isProcessed 状态
-        auto callerInfoIt = globalValueMap.find(caller);
-        if (callerInfoIt == globalValueMap.end()) {
-            throw std::invalid_argument("Caller globalValue must be in globalValueMap");
-        }
-
-        bool callerProcessed = callerInfoIt->second.isProcessed;
-
-        // 如果一个已被处理一个未被处理，则一定不同组
-        if (currentGVProcessed != callerProcessed) {
-            return false;
-        }
-    }
-
-    return true; // 所有调用者都在group中且isProcessed状态一致
-}
-
-/**
- * 判断指定符号的被调用者是否全部在指定的组中
- *
- * @param GV 要检查的符号，该符号必须在group和globalValueMap中
- * @param group 符号组
- * @param globalValueMap 符号信息映射表
- * @return true 如果GV的所有被调用者都在group中
- * @return false 如果GV有被调用者不在group中
- * @throws std::invalid_argument 如果F不在group或globalValueMap中
- */
-bool GlobalValueInfo::areAllCalledsInGroup(llvm::GlobalValue *GV, const llvm::DenseSet<llvm::GlobalValue *> &group,
-                                           const llvm::DenseMap<llvm::GlobalValue *, GlobalValueInfo> &globalValueMap) {
-    // 参数检查
-    if (group.find(GV) == group.end()) {
-        throw std::invalid_argument("GlobalValue must be in the group");
-    }
-
-    auto infoIt = globalValueMap.find(GV);
-    if (infoIt == globalValueMap.end()) {
-        throw std::invalid_argument("GlobalValue must be in globalValueMap");
-    }
-
-    const auto &calleds = infoIt->second.calleds;
-
-    // 如果符号没有被调用者，那么所有被调用者（没有）都在group中
-    if (calleds.empty()) {
-        return true;
-    }
-
-    // 获取当前符号的 isProcessed 状态
-    bool currentGVProcessed = infoIt->second.isProcessed;
-
-    // 检查每个被调用者是否都在group中，并检查 isProcessed 状态
-    for (llvm::GlobalValue *called : calleds) {
-        // 检查被调用者是否在group中
-        if (group.find(called) == group.end()) {
-            return false; // 发现一个不在group中的被调用者
-        }
-
-        // 检查被调用者的 isProcessed 状态
-        auto calledInfoIt = globalValueMap.find(called);
-        if (calledInfoIt == globalValueMap.end()) {
-            throw std::invalid_argument("Called globalValue must be in globalValueMap");
-        }
-
-        bool calledProcessed = calledInfoIt->second.isProcessed;
-
-        // 如果一个已被处理一个未被处理，则一定不同组
-        if (currentGVProcessed != calledProcessed) {
-            return false;
-        }
-    }
-
-    return true; // 所有被调用者都在group中且isProcessed状态一致
-}
@@ -0,0 +1,232 @@
+// extractor.cpp
+#include "extractor.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/IR/Comdat.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalAlias.h"
+#include "llvm/IR/GlobalIFunc.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Metadata.h"
+#include "llvm/IR/ValueMap.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/ValueMapper.h"
+
+namespace {
+
+/**
+ * @brief 组外全局对象的按需声明
+ *
+ * ValueMapper遇到不在映射表中的值时调用materialize。源模块中的全局对象在这里
+ * 第一次被引用时才在目标模块中创建声明，没有被组内定义引用的符号不会出现在新模块中。
+ */
+class DeclarationMaterializer final : public llvm::ValueMaterializer {
+  public:
+    DeclarationMaterializer(const llvm::Module &sourceModule, llvm::Module &targetModule)
+        : source(sourceModule), target(targetModule) {}
+
+    llvm::Value *materialize(llvm::Value *V) override {
+        auto *GV = llvm::dyn_cast<llvm::GlobalValue>(V);
+        if (!GV || GV->getParent() != &source)
+            return nullptr;
+        return createDeclaration(*GV);
+    }
+
+  private:
+    llvm::GlobalValue *createDeclaration(const llvm::GlobalValue &GV);
+
+    const llvm::Module &source;
+    llvm::Module &target;
+};
+
+llvm::GlobalValue *DeclarationMaterializer::createDeclaration(const llvm::GlobalValue &GV) {
+    llvm::GlobalValue *decl = nullptr;
+    if (const auto *F = llvm::dyn_cast<llvm::Function>(&GV)) {
+        llvm::Function *NF = llvm::Function::Create(F->getFunctionType(), llvm::GlobalValue::ExternalLinkage,
+                                                    F->getAddressSpace(), F->getName(), &target);
+        NF->copyAttributesFrom(F);
+        // 声明上不能带personality/prefix/prologue
+        NF->setPersonalityFn(nullptr);
+        NF->setPrefixData(nullptr);
+        NF->setPrologueData(nullptr);
+        decl = NF;
+    } else if (const auto *GVar = llvm::dyn_cast<llvm::GlobalVariable>(&GV)) {
+        auto *NGV = new llvm::GlobalVariable(target, GVar->getValueType(), GVar->isConstant(),
+                                             llvm::GlobalValue::ExternalLinkage, nullptr, GVar->getName(), nullptr,
+                                             GVar->getThreadLocalMode(), GVar->getAddressSpace());
+        NGV->copyAttributesFrom(GVar);
+        decl = NGV;
+    } else if (auto *FT = llvm::dyn_cast<llvm::FunctionType>(GV.getValueType())) {
+        // 别名和ifunc按值类型声明为函数或全局变量
+        decl = llvm::Function::Create(FT, llvm::GlobalValue::ExternalLinkage, GV.getAddressSpace(), GV.getName(),
+                                      &target);
+    } else {
+        decl = new llvm::GlobalVariable(target, GV.getValueType(), false, llvm::GlobalValue::ExternalLinkage, nullptr,
+                                        GV.getName(), nullptr, GV.getThreadLocalMode(), GV.getAddressSpace());
+    }
+
+    if (GV.isDeclaration()) {
+        // 源模块中本来就是声明（外部函数、extern_weak等），保持原有链接属性
+        decl->setLinkage(GV.getLinkage());
+    } else {
+        // 在其他组中定义：外部链接、默认可见性
+        decl->setLinkage(llvm::GlobalValue::ExternalLinkage);
+        decl->setVisibility(llvm::GlobalValue::DefaultVisibility);
+        decl->setDSOLocal(false);
+    }
+    return decl;
+}
+
+void copyComdat(llvm::GlobalObject &dst, const llvm::GlobalObject &src) {
+    const llvm::Comdat *comdat = src.getComdat();
+    if (!comdat)
+        return;
+    llvm::Comdat *newComdat = dst.getParent()->getOrInsertComdat(comdat->getName());
+    newComdat->setSelectionKind(comdat->getSelectionKind());
+    dst.setComdat(newComdat);
+}
+
+} // namespace
+
+/**
+ * @brief 抽取一组符号到新模块
+ *
+ * 1. 为组内所有定义创建空壳，组内相互引用直接映射到定义；
+ *    别名和ifunc跟随其指向的对象（resolver函数），所在的组负责定义它们；
+ * 2. 映射全局变量初始值和函数体，组外引用由DeclarationMaterializer创建为声明；
+ * 3. 复制命名元数据；
+ * 4. 被组外引用的局部链接符号提升为外部链接，别名按其指向的对象判断。
+ */
+std::unique_ptr<llvm::Module> GroupExtractor::extract(llvm::ArrayRef<llvm::GlobalValue *> definitions,
+                                                      llvm::ArrayRef<llvm::GlobalValue *> exported,
+                                                      llvm::StringRef moduleName) const {
+    auto newM = std::make_unique<llvm::Module>(moduleName, source.getContext());
+    newM->setSourceFileName(source.getSourceFileName());
+    newM->setDataLayout(source.getDataLayout());
+    newM->setTargetTriple(source.getTargetTriple());
+    newM->setModuleInlineAsm(source.getModuleInlineAsm());
+#if LLVM_VERSION_MAJOR >= 19
+    // 调试记录格式需与源模块一致，CloneFunctionInto才能直接搬运函数体中的调试记录
+    newM->IsNewDbgInfoFormat = source.IsNewDbgInfoFormat;
+#endif
+
+    llvm::ValueToValueMapTy vmap;
+    DeclarationMaterializer materializer(source, *newM);
+
+    // 1. 组内定义的空壳
+    for (llvm::GlobalValue *GV : definitions) {
+        if (auto *F = llvm::dyn_cast<llvm::Function>(GV)) {
+            llvm::Function *NF = llvm::Function::Create(F->getFunctionType(), F->getLinkage(), F->getAddressSpace(),
+                                                        F->getName(), newM.get());
+            NF->copyAttributesFrom(F);
+            copyComdat(*NF, *F);
+            vmap[F] = NF;
+        } else if (auto *GVar = llvm::dyn_cast<llvm::GlobalVariable>(GV)) {
+            auto *NGV = new llvm::GlobalVariable(*newM, GVar->getValueType(), GVar->isConstant(), GVar->getLinkage(),
+                                                 nullptr, GVar->getName(), nullptr, GVar->getThreadLocalMode(),
+                                                 GVar->getAddressSpace());
+            NGV->copyAttributesFrom(GVar);
+            copyComdat(*NGV, *GVar);
+            vmap[GVar] = NGV;
+        }
+    }
+
+    // 别名和ifunc没有独立的符号ID，指向的对象在本组时由本组定义，其他组引用时只生成声明
+    llvm::SmallPtrSet<const llvm::GlobalValue *, 32> defined(definitions.begin(), definitions.end());
+    llvm::SmallVector<std::pair<const llvm::GlobalAlias *, llvm::GlobalAlias *>, 4> aliases;
+    llvm::SmallVector<std::pair<const llvm::GlobalIFunc *, llvm::GlobalIFunc *>, 4> ifuncs;
+    for (const llvm::GlobalAlias &GA : source.aliases()) {
+        if (!defined.count(GA.getAliaseeObject()))
+            continue;
+        llvm::GlobalAlias *NA = llvm::GlobalAlias::create(GA.getValueType(), GA.getAddressSpace(), GA.getLinkage(),
+                                                          GA.getName(), newM.get());
+        NA->copyAttributesFrom(&GA);
+        vmap[&GA] = NA;
+        aliases.emplace_back(&GA, NA);
+    }
+    for (const llvm::GlobalIFunc &GI : source.ifuncs()) {
+        if (!defined.count(GI.getResolverFunction()))
+            continue;
+        llvm::GlobalIFunc *NI = llvm::GlobalIFunc::create(GI.getValueType(), GI.getAddressSpace(), GI.getLinkage(),
+                                                          GI.getName(), nullptr, newM.get());
+        NI->copyAttributesFrom(&GI);
+        vmap[&GI] = NI;
+        ifuncs.emplace_back(&GI, NI);
+    }
+
+    // 2. 全局变量初始值、元数据和函数体
+    for (llvm::GlobalValue *GV : definitions) {
+        if (auto *GVar = llvm::dyn_cast<llvm::GlobalVariable>(GV)) {
+            auto *NGV = llvm::cast<llvm::GlobalVariable>(vmap[GVar]);
+            if (GVar->hasInitializer()) {
+                NGV->setInitializer(
+                    llvm::MapValue(GVar->getInitializer(), vmap, llvm::RF_None, nullptr, &materializer));
+            }
+
+            llvm::SmallVector<std::pair<unsigned, llvm::MDNode *>, 1> MDs;
+            GVar->getAllMetadata(MDs);
+            for (const auto &[kind, MD] : MDs) {
+                NGV->addMetadata(kind, *llvm::MapMetadata(MD, vmap, llvm::RF_None, nullptr, &materializer));
+            }
+        } else if (auto *F = llvm::dyn_cast<llvm::Function>(GV)) {
+            auto *NF = llvm::cast<llvm::Function>(vmap[F]);
+            if (F->isDeclaration()) {
+                NF->setPersonalityFn(nullptr);
+                continue;
+            }
+
+            llvm::Function::arg_iterator destArg = NF->arg_begin();
+            for (const llvm::Argument &arg : F->args()) {
+                destArg->setName(arg.getName());
+                vmap[&arg] = &*destArg++;
+            }
+
+            llvm::SmallVector<llvm::ReturnInst *, 8> returns;
+            llvm::CloneFunctionInto(NF, F, vmap, llvm::CloneFunctionChangeType::ClonedModule, returns, "", nullptr,
+                                    nullptr, &materializer);
+        }
+    }
+
+    for (const auto &[GA, NA] : aliases) {
+        NA->setAliasee(llvm::MapValue(GA->getAliasee(), vmap, llvm::RF_None, nullptr, &materializer));
+    }
+    for (const auto &[GI, NI] : ifuncs) {
+        NI->setResolver(llvm::MapValue(GI->getResolver(), vmap, llvm::RF_None, nullptr, &materializer));
+    }
+
+    // 3. 命名元数据（模块标志、调试信息编译单元等）
+    for (const llvm::NamedMDNode &NMD : source.named_metadata()) {
+        llvm::NamedMDNode *newNMD = newM->getOrInsertNamedMetadata(NMD.getName());
+        for (const llvm::MDNode *N : NMD.operands()) {
+            newNMD->addOperand(llvm::MapMetadata(N, vmap, llvm::RF_None, nullptr, &materializer));
+        }
+    }
+
+    // 4. 被组外引用的局部符号需要对外可见
+    auto exportLocal = [](llvm::GlobalValue *newGV) {
+        if (newGV->hasLocalLinkage()) {
+            newGV->setLinkage(llvm::GlobalValue::ExternalLinkage);
+            newGV->setVisibility(llvm::GlobalValue::DefaultVisibility);
+        }
+    };
+    llvm::SmallPtrSet<const llvm::GlobalValue *, 32> exportedSet(exported.begin(), exported.end());
+    for (llvm::GlobalValue *GV : exported) {
+        auto it = vmap.find(GV);
+        if (it != vmap.end())
+            exportLocal(llvm::cast<llvm::GlobalValue>(it->second));
+    }
+    // 组外经别名的引用在调用图中记在指向的对象上
+    for (const auto &[GA, NA] : aliases) {
+        if (exportedSet.count(GA->getAliaseeObject()))
+            exportLocal(NA);
+    }
+    for (const auto &[GI, NI] : ifuncs) {
+        if (exportedSet.count(GI->getResolverFunction()))
+            exportLocal(NI);
+    }
+
+    return newM;
+}
@@ -22,6 +22,7 @@
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
+#include <chrono>
 #include <filesystem>
 #include <fstream>
 #include <future>
@@ -255,6 +256,10 @@ bool BCLinker::executeLdLld(llvm::StringRef responseFilePath, llvm::StringRef ex
     return true;
 }
 
+uint64_t BCLinker::elapsedMicros(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
 // 处理单个组的两阶段任务
 void BCLinker::processGroupTask(int groupId, std::promise<bool> &promise) {
     std::string responseFileNoDep =
@@ -265,6 +270,9 @@ void BCLinker::processGroupTask(int groupId, std::promise<bool> &promise) {
             .string();
 
     bool success = true;
+    // 拆分时按优化放置和该组的优化方案确定的LTO参数
+    const std::vector<EmissionRecord> &records = common.getEmissionRecords();
+    std::string ltoFlags = static_cast<size_t>(groupId) < records.size() ? records[groupId].linkerFlags : "";
 
     // 第一阶段：执行无依赖版本
     // {
@@ -272,7 +280,10 @@ void BCLinker::processGroupTask(int groupId, std::promise<bool> &promise) {
     //     logger.log("-- 组 " + std::to_string(groupId) + ": 开始第一阶段 (无依赖版本)");
     // }
 
-    if (!executeLdLld(responseFileNoDep, "")) {
+    auto phaseStart = std::chrono::steady_clock::now();
+    bool phase1Ok = executeLdLld(responseFileNoDep, ltoFlags);
+    phase1Micros += elapsedMicros(phaseStart);
+    if (!phase1Ok) {
         success = false;
         std::lock_guard<std::mutex> lock(logMutex);
         logger.logWarning("-- 组 " + std::to_string(groupId) + " 第一阶段失败");
@@ -310,7 +321,10 @@ void BCLinker::processGroupTask(int groupId, std::promise<bool> &promise) {
     //     logger.log("-- 组 " + std::to_string(groupId) + ": 开始第二阶段 (有依赖版本)");
     // }
 
-    if (!executeLdLld(responseFileWithDep, "")) {
+    phaseStart = std::chrono::steady_clock::now();
+    bool phase2Ok = executeLdLld(responseFileWithDep, ltoFlags);
+    phase2Micros += elapsedMicros(phaseStart);
+    if (!phase2Ok) {
         // if (!executeLdLld(responseFileWithDep, "--no-undefined")) {
         success = false;
         std::lock_guard<std::mutex> lock(logMutex);
@@ -364,6 +378,9 @@ bool BCLinker::executeAllGroups() {
     }
     if (allSuccess)
         logger.log("✓ 全部编译成功!");
+    // 各组并发执行，累计值是ld.lld的总耗时而非墙钟时间
+    logger.log("ld.lld累计耗时: 第一阶段 " + std::to_string(phase1Micros.load() / 1000) + " ms, 第二阶段 " +
+               std::to_string(phase2Micros.load() / 1000) + " ms");
 
     return allSuccess;
 }
@@ -4,8 +4,12 @@
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <mutex>
 #include <string>
 
+// 所有Logger实例写同一个日志文件和标准输出，多线程输出时按行串行化
+static std::mutex outputMutex;
+
 Logger::Logger() {
     Config config;
     logFile.open(config.workSpace + "logs/bc_splitter.log", std::ios::out | std::ios::app);
@@ -19,6 +23,7 @@ Logger::~Logger() {
 }
 
 void Logger::log(llvm::StringRef message) {
+    std::lock_guard<std::mutex> lock(outputMutex);
     if (logFile.is_open()) {
         logFile << message.str() << std::endl;
     }
@@ -26,6 +31,7 @@ void Logger::log(llvm::StringRef message) {
 }
 
 void Logger::logError(llvm::StringRef message) {
+    std::lock_guard<std::mutex> lock(outputMutex);
     std::string errorMsg = "[ERROR] " + message.str();
     if (logFile.is_open()) {
         logFile << errorMsg << std::endl;
@@ -34,6 +40,7 @@ void Logger::logError(llvm::StringRef message) {
 }
 
 void Logger::logWarning(llvm::StringRef message) {
+    std::lock_guard<std::mutex> lock(outputMutex);
     std::string warnMsg = "[WARNING] " + message.str();
     if (logFile.is_open()) {
         logFile << warnMsg << std::endl;
@@ -42,6 +49,7 @@ void Logger::logWarning(llvm::StringRef message) {
 }
 
 void Logger::logToFile(llvm::StringRef message) {
+    std::lock_guard<std::mutex> lock(outputMutex);
     if (logFile.is_open()) {
         logFile << message.str() << std::endl;
     }
@@ -2,6 +2,7 @@
 #include "common.h"
 #include "linker.h"
 #include "logging.h"
+#include "optimizer.h"
 #include "splitter.h"
 #include "verifier.h"
 #include "workdirectory.h"
@@ -9,13 +10,22 @@
 #include <filesystem>
 #include <iostream>
 #include <regex>
+#include <string>
+#include <vector>
+
+static void printUsage(const char *program) {
+    std::cerr << "用法: " << program << " <输入.bc> <输出前缀> [--clone/clear] [Pass选项]" << std::endl;
+    std::cerr << "选项:" << std::endl;
+    std::cerr << "  --clone    使用LLVM Clone模式（默认使用手动模式）" << std::endl;
+    std::cerr << "  --clear    清理构建环境" << std::endl;
+    std::cerr << "  --load-pass-plugin=<插件.so>  加载Pass插件，可重复指定" << std::endl;
+    std::cerr << "  --pre-o2-passes=<管道>        在O2之前运行的文本管道（opt -passes语法）" << std::endl;
+    std::cerr << "  --post-o2-passes=<管道>       在O2之后运行的文本管道" << std::endl;
+}
 
 int main(int argc, char *argv[]) {
-    if (argc < 3 || argc > 4) {
-        std::cerr << "用法: " << argv[0] << " <输入.bc> <输出前缀> [--clone/clear]" << std::endl;
-        std::cerr << "选项:" << std::endl;
-        std::cerr << "  --clone    使用LLVM Clone模式（默认使用手动模式）" << std::endl;
-        std::cerr << "  --clear    清理构建环境" << std::endl;
+    if (argc < 3) {
+        printUsage(argv[0]);
         return 1;
     }
 
@@ -35,14 +45,44 @@ int main(int argc, char *argv[]) {
         return 1;
     }
 
-    if (argc == 4) {
-        std::string option = argv[3];
+    std::vector<std::string> pluginPaths;
+    std::string prePassPipeline;
+    std::string postPassPipeline;
+    for (int i = 3; i < argc; i++) {
+        llvm::StringRef option = argv[i];
         if (option == "--clone") {
             useCloneMode = true;
         } else if (option == "--clear") {
             std::cout << "清理构建环境..." << std::endl;
             worker.cleanupConfigFiles(outputPrefix);
             return 0;
+        } else if (option.consume_front("--load-pass-plugin=")) {
+            pluginPaths.push_back(option.str());
+        } else if (option.consume_front("--pre-o2-passes=")) {
+            prePassPipeline = option.str();
+        } else if (option.consume_front("--post-o2-passes=")) {
+            postPassPipeline = option.str();
+        } else {
+            std::cerr << "未知选项: " << option.str() << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    // 插件必须在创建任何优化器之前加载，文本管道在加载插件之后才能检查
+    for (const std::string &path : pluginPaths) {
+        std::string error;
+        if (!custom::PassPluginRegistry::load(path, error)) {
+            std::cerr << "无法加载Pass插件 " << path << ": " << error << std::endl;
+            return 1;
+        }
+        std::cout << "已加载Pass插件: " << path << std::endl;
+    }
+    for (const std::string &pipeline : {prePassPipeline, postPassPipeline}) {
+        std::string error;
+        if (!pipeline.empty() && !custom::CustomOptimizer::checkPipeline(pipeline, error)) {
+            std::cerr << error << std::endl;
+            return 1;
         }
     }
 
@@ -61,6 +101,7 @@ int main(int argc, char *argv[]) {
         Logger logger;
 
         splitter.setCloneMode(useCloneMode);
+        splitter.setPassPipelines(prePassPipeline, postPassPipeline);
 
         if (!splitter.loadBCFile(inputFile)) {
             std::cerr << "无法加载BC文件: " << inputFile << std::endl;
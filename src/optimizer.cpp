@@ -89,22 +89,85 @@ llvm::PreservedAnalyses ExampleCustomPass::run(llvm::Module &M, llvm::ModuleAnal
     return Changed ? llvm::PreservedAnalyses::none() : llvm::PreservedAnalyses::all();
 }
 
+bool OptimizationProfile::parse(llvm::StringRef Spec, OptimizationProfile &Profile, std::string &Error) {
+    Spec = Spec.trim();
+    Profile = OptimizationProfile();
+    if (Spec.consume_front("pipeline:")) {
+        Spec = Spec.trim();
+        if (Spec.empty()) {
+            Error = "文本管道为空";
+            return false;
+        }
+        if (!CustomOptimizer::checkPipeline(Spec, Error))
+            return false;
+        Profile.Pipeline = Spec.str();
+        return true;
+    }
+
+    static const std::pair<const char *, llvm::OptimizationLevel> Levels[] = {
+        {"O0", llvm::OptimizationLevel::O0}, {"O1", llvm::OptimizationLevel::O1}, {"O2", llvm::OptimizationLevel::O2},
+        {"O3", llvm::OptimizationLevel::O3}, {"Os", llvm::OptimizationLevel::Os}, {"Oz", llvm::OptimizationLevel::Oz}};
+    for (const auto &Entry : Levels) {
+        if (Spec == Entry.first) {
+            Profile.Level = Entry.second;
+            return true;
+        }
+    }
+    Error = "未知的优化方案: " + Spec.str() + "（应为 O0/O1/O2/O3/Os/Oz 或 pipeline:<文本管道>）";
+    return false;
+}
+
+std::string OptimizationProfile::getName() const {
+    if (!Pipeline.empty())
+        return "pipeline:" + Pipeline;
+    if (Level == llvm::OptimizationLevel::Os)
+        return "Os";
+    if (Level == llvm::OptimizationLevel::Oz)
+        return "Oz";
+    return "O" + std::to_string(Level.getSpeedupLevel());
+}
+
 // CustomOptimizer 实现
-CustomOptimizer::CustomOptimizer(const custom::OptimizerConfig &Config) : Config(Config) {
+CustomOptimizer::CustomOptimizer(const custom::OptimizerConfig &Config)
+    : PB(nullptr, llvm::PipelineTuningOptions(), {}, &PIC), Config(Config) {
+    Recorder.registerCallbacks(PIC);
+    // 插件可能注册自己的分析，必须在注册分析之前完成
+    registerPassCallbacks(PB, &Recorder);
     // 创建分析管理器
     LAM = std::make_unique<llvm::LoopAnalysisManager>();
     FAM = std::make_unique<llvm::FunctionAnalysisManager>();
     CGAM = std::make_unique<llvm::CGSCCAnalysisManager>();
     MAM = std::make_unique<llvm::ModuleAnalysisManager>();
+    initializeAnalysisManagers();
 }
 
-void CustomOptimizer::initializeAnalysisManagers(llvm::Module &M) {
-    // 清空之前的分析结果
-    LAM->clear();
-    FAM->clear();
-    CGAM->clear();
-    MAM->clear();
+void CustomOptimizer::registerPassCallbacks(llvm::PassBuilder &PB, PassTimingRecorder *Recorder) {
+    // 内置自定义 Pass 可以在文本管道中按名字使用
+    PB.registerPipelineParsingCallback(
+        [Recorder](llvm::StringRef Name, llvm::ModulePassManager &MPM,
+                   llvm::ArrayRef<llvm::PassBuilder::PipelineElement>) {
+            if (Name == "example-custom") {
+                MPM.addPass(CustomPassAdapter(std::make_shared<ExampleCustomPass>(), Recorder));
+                return true;
+            }
+            return false;
+        });
+    PassPluginRegistry::registerCallbacks(PB);
+}
+
+bool CustomOptimizer::checkPipeline(llvm::StringRef Pipeline, std::string &Error) {
+    // 只检查语法，不需要注册分析
+    llvm::PassBuilder PB;
+    registerPassCallbacks(PB);
+    llvm::ModulePassManager MPM;
+    if (auto Err = PB.parsePassPipeline(MPM, Pipeline)) {
+        Error = "无法解析文本管道: " + llvm::toString(std::move(Err));
+        return false;
+    }
+    return true;
+}
 
+void CustomOptimizer::initializeAnalysisManagers() {
     // 注册标准分析
     PB.registerModuleAnalyses(*MAM);
     PB.registerCGSCCAnalyses(*CGAM);
@@ -113,12 +176,20 @@ void CustomOptimizer::initializeAnalysisManagers(llvm::Module &M) {
     PB.crossRegisterProxies(*LAM, *FAM, *CGAM, *MAM);
 }
 
+void CustomOptimizer::releaseAnalyses() {
+    LAM->clear();
+    FAM->clear();
+    CGAM->clear();
+    MAM->clear();
+}
+
 void CustomOptimizer::addPass(std::unique_ptr<CustomPass> Pass, bool before_o2) {
     if (before_o2) {
         PrePasses.push_back(std::move(Pass));
     } else {
         PostPasses.push_back(std::move(Pass));
     }
+    Pipelines.clear();
 }
 
 void CustomOptimizer::addLambdaPass(CustomPassFunc Func, const std::string &Name, bool before_o2) {
@@ -128,78 +199,160 @@ void CustomOptimizer::addLambdaPass(CustomPassFunc Func, const std::string &Name
 void CustomOptimizer::clearPasses() {
     PrePasses.clear();
     PostPasses.clear();
+    Pipelines.clear();
 }
 
-bool CustomOptimizer::runOptimization(llvm::Module &M) {
-    try {
-        // 初始化分析管理器
-        initializeAnalysisManagers(M);
-
-        // 构建 ModulePassManager
-        llvm::ModulePassManager MPM;
-
-        // 阶段1: 在 O2 之前运行的自定义 Pass
-        if (Config.run_before_o2) {
-            for (const auto &Pass : PrePasses) {
-                if (Config.enable_debug) {
-                    logger.logToFile("Running pre-O2 pass: " + Pass->getName());
-                }
+void CustomOptimizer::copyPassesFrom(const CustomOptimizer &Other) {
+    for (const auto &Pass : Other.PrePasses) {
+        PrePasses.push_back(Pass->clone());
+    }
+    for (const auto &Pass : Other.PostPasses) {
+        PostPasses.push_back(Pass->clone());
+    }
+    Pipelines.clear();
+}
 
-                // 将自定义 Pass 包装到适配器中
-                // MPM.addPass();
-            }
+llvm::ModulePassManager *CustomOptimizer::getPipeline(const OptimizationProfile &Profile) {
+    std::unique_ptr<llvm::ModulePassManager> &Slot = Pipelines[Profile.getName()];
+    if (!Slot) {
+        auto MPM = std::make_unique<llvm::ModulePassManager>();
+        if (!buildPipeline(Profile, *MPM)) {
+            Pipelines.erase(Profile.getName());
+            return nullptr;
         }
+        Slot = std::move(MPM);
+    }
+    return Slot.get();
+}
+
+bool CustomOptimizer::addTextPipeline(llvm::ModulePassManager &MPM, llvm::StringRef Pipeline) {
+    if (Pipeline.empty())
+        return true;
+    if (auto Err = PB.parsePassPipeline(MPM, Pipeline)) {
+        logger.logError("[Optimizer] Could not parse pipeline: " + Pipeline.str() + " - " +
+                        llvm::toString(std::move(Err)));
+        return false;
+    }
+    return true;
+}
 
-        // 阶段2: LLVM O2 优化管道
+bool CustomOptimizer::buildPipeline(const OptimizationProfile &Profile, llvm::ModulePassManager &MPM) {
+    // 阶段1: 在 O2 之前运行的自定义 Pass 和文本管道
+    for (const auto &Pass : PrePasses) {
         if (Config.enable_debug) {
-            logger.logToFile("Running LLVM O2 optimization pipeline");
+            logger.logToFile("Scheduling pre-O2 pass: " + Pass->getName());
         }
 
-        if (auto Err = PB.parsePassPipeline(MPM, "objc-arc-contract")) {
-            logger.logError("[Optimizer] Could not parse pipeline: createObjCARCContractPass");
+        // 将自定义 Pass 包装到适配器中
+        MPM.addPass(CustomPassAdapter(Pass, &Recorder));
+    }
+    if (!addTextPipeline(MPM, Config.pre_o2_pipeline))
+        return false;
+
+    // 阶段2: 按优化方案构建的 LLVM 优化管道
+    if (Config.enable_debug) {
+        logger.logToFile("Building LLVM optimization pipeline: " + Profile.getName());
+    }
+
+    if (auto Err = PB.parsePassPipeline(MPM, "objc-arc-contract")) {
+        logger.logError("[Optimizer] Could not parse pipeline: createObjCARCContractPass");
+        return false;
+    }
+
+    if (!Profile.Pipeline.empty()) {
+        if (!addTextPipeline(MPM, Profile.Pipeline))
             return false;
-        }
+    } else if (Config.pre_link_only) {
+        MPM.addPass(PB.buildLTOPreLinkDefaultPipeline(Profile.Level));
+    } else {
+        MPM.addPass(PB.buildPerModuleDefaultPipeline(Profile.Level, llvm::ThinOrFullLTOPhase::FullLTOPostLink));
+    }
 
-        MPM.addPass(
-            PB.buildPerModuleDefaultPipeline(llvm::OptimizationLevel::O2, llvm::ThinOrFullLTOPhase::FullLTOPostLink));
+    if (Config.enable_debug) {
+        logger.logToFile("[Optimizer] Building LLVM optimization pipeline (end)");
+    }
 
+    // 阶段3: 在 O2 之后运行的自定义 Pass 和文本管道
+    for (const auto &Pass : PostPasses) {
         if (Config.enable_debug) {
-            logger.logToFile("[Optimizer] Running LLVM O2 optimization pipeline (end)");
+            logger.logToFile("Scheduling post-O2 pass: " + Pass->getName());
         }
 
-        // 阶段3: 在 O2 之后运行的自定义 Pass
-        if (Config.run_after_o2) {
-            for (const auto &Pass : PostPasses) {
-                if (Config.enable_debug) {
-                    logger.logToFile("Running post-O2 pass: " + Pass->getName());
-                }
+        MPM.addPass(CustomPassAdapter(Pass, &Recorder));
+    }
+    if (!addTextPipeline(MPM, Config.post_o2_pipeline))
+        return false;
 
-                // MPM.addPass();
-            }
-        }
+    return true;
+}
+
+bool CustomOptimizer::runOptimization(llvm::Module &M, const OptimizationProfile &Profile,
+                                      OptimizationTelemetry *Telemetry) {
+    try {
+        // 每个方案的管道只在第一次使用或Pass列表变化后构建
+        llvm::ModulePassManager *MPM = getPipeline(Profile);
+        if (!MPM)
+            return false;
 
         // 运行优化
         if (Config.enable_debug) {
             logger.logToFile("[Optimizer] Starting optimization pipeline execution");
         }
-        MPM.run(M, *MAM);
+        if (Telemetry) {
+            Telemetry->Profile = Profile.getName();
+            Recorder.start(M, *Telemetry);
+        }
+        MPM->run(M, *MAM);
+        Recorder.finish(M);
+        releaseAnalyses();
         if (Config.enable_debug) {
             logger.logToFile("[Optimizer] Optimization pipeline execution finished");
         }
 
         return true;
     } catch (const std::exception &e) {
+        Recorder.finish(M);
+        releaseAnalyses();
         logger.logToFile("Optimization failed: " + std::string(e.what()));
         return false;
     }
 }
 
+std::vector<llvm::PassPlugin> &PassPluginRegistry::plugins() {
+    static std::vector<llvm::PassPlugin> Plugins;
+    return Plugins;
+}
+
+bool PassPluginRegistry::load(const std::string &Path, std::string &Error) {
+    llvm::Expected<llvm::PassPlugin> PluginOrErr = llvm::PassPlugin::Load(Path);
+    if (!PluginOrErr) {
+        Error = llvm::toString(PluginOrErr.takeError());
+        return false;
+    }
+    plugins().push_back(std::move(*PluginOrErr));
+    return true;
+}
+
+void PassPluginRegistry::registerCallbacks(llvm::PassBuilder &PB) {
+    for (const llvm::PassPlugin &Plugin : plugins()) {
+        Plugin.registerPassBuilderCallbacks(PB);
+    }
+}
+
+OptimizerPool::OptimizerPool(unsigned WorkerCount, const CustomOptimizer &Prototype) {
+    Optimizers.reserve(WorkerCount);
+    for (unsigned I = 0; I < WorkerCount; I++) {
+        Optimizers.push_back(std::make_unique<CustomOptimizer>(Prototype.getConfig()));
+        Optimizers.back()->copyPassesFrom(Prototype);
+    }
+}
+
 // 工具函数实现
 bool optimizeModule(llvm::Module &M, const std::string &OutputFilename, const custom::OptimizerConfig &Config) {
     CustomOptimizer Optimizer(Config);
 
-    // 添加示例自定义 Pass
-    Optimizer.addPass(std::make_unique<ExampleCustomPass>(), Config.run_before_o2);
+    // 添加示例自定义 Pass，在 O2 之后运行
+    Optimizer.addPass(std::make_unique<ExampleCustomPass>());
 
     if (!Optimizer.runOptimization(M)) {
         return false;
@@ -0,0 +1,99 @@
+// profile.cpp
+#include "profile.h"
+#include "llvm/Support/MemoryBuffer.h"
+
+bool OptimizationProfileTable::load(llvm::StringRef path, std::string &error) {
+    clear();
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> bufferOrErr = llvm::MemoryBuffer::getFile(path);
+    if (!bufferOrErr) {
+        error = "无法读取 " + path.str() + ": " + bufferOrErr.getError().message();
+        return false;
+    }
+
+    llvm::SmallVector<llvm::StringRef, 64> lines;
+    (*bufferOrErr)->getBuffer().split(lines, '\n');
+    for (size_t i = 0; i < lines.size(); i++) {
+        llvm::StringRef line = lines[i].split('#').first.trim();
+        if (line.empty())
+            continue;
+
+        std::string lineError;
+        auto [selector, spec] = line.split('=');
+        custom::OptimizationProfile profile;
+        if (!line.contains('=') || selector.trim().empty()) {
+            lineError = "应为 <选择器> = <方案>";
+        } else if (custom::OptimizationProfile::parse(spec, profile, lineError)) {
+            addRule(selector.trim(), profile, lineError);
+        }
+
+        if (!lineError.empty()) {
+            error = path.str() + ":" + std::to_string(i + 1) + ": " + lineError;
+            clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool OptimizationProfileTable::addRule(llvm::StringRef selector, const custom::OptimizationProfile &profile,
+                                       std::string &error) {
+    if (selector == "default") {
+        defaultProfile = profile;
+    } else if (selector == "public") {
+        hasPublicProfile = true;
+        publicProfile = profile;
+    } else if (selector.consume_front("group:")) {
+        size_t groupId = 0;
+        if (selector.trim().getAsInteger(10, groupId)) {
+            error = "无效的组号: " + selector.str();
+            return false;
+        }
+        groupProfiles[groupId] = profile;
+    } else {
+        for (PackageRule &rule : packageRules) {
+            if (rule.pattern == selector) {
+                rule.profile = profile;
+                return true;
+            }
+        }
+        packageRules.push_back({selector.str(), profile});
+    }
+    return true;
+}
+
+void OptimizationProfileTable::clear() {
+    defaultProfile = custom::OptimizationProfile();
+    hasPublicProfile = false;
+    publicProfile = custom::OptimizationProfile();
+    groupProfiles.clear();
+    packageRules.clear();
+}
+
+const custom::OptimizationProfile &OptimizationProfileTable::select(size_t groupId,
+                                                                   llvm::StringRef packageName) const {
+    auto it = groupProfiles.find(groupId);
+    if (it != groupProfiles.end())
+        return it->second;
+
+    // 包名规则按'.'分段做前缀匹配，取最长的模式
+    const PackageRule *best = nullptr;
+    if (!packageName.empty()) {
+        for (const PackageRule &rule : packageRules) {
+            llvm::StringRef pattern = rule.pattern;
+            bool matches = packageName == pattern ||
+                           (packageName.starts_with(pattern) && packageName[pattern.size()] == '.');
+            if (matches && (!best || pattern.size() > best->pattern.size()))
+                best = &rule;
+        }
+    }
+    if (best)
+        return best->profile;
+
+    if (groupId == 0 && hasPublicProfile)
+        return publicProfile;
+    return defaultProfile;
+}
+
+size_t OptimizationProfileTable::getRuleCount() const {
+    return groupProfiles.size() + packageRules.size() + (hasPublicProfile ? 1 : 0);
+}
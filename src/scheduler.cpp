@@ -0,0 +1,32 @@
+// scheduler.cpp
+#include "scheduler.h"
+#include <algorithm>
+#include <unistd.h>
+
+void MemoryBudget::acquire(size_t bytes) {
+    std::unique_lock<std::mutex> lock(mutex);
+    released.wait(lock, [&]() { return inUse == 0 || inUse + bytes <= limit; });
+    inUse += bytes;
+    peak = std::max(peak, inUse);
+}
+
+void MemoryBudget::release(size_t bytes) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        inUse -= std::min(bytes, inUse);
+    }
+    released.notify_all();
+}
+
+size_t MemoryBudget::getPeak() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return peak;
+}
+
+size_t MemoryBudget::getPhysicalMemory() {
+    long pages = sysconf(_SC_PHYS_PAGES);
+    long pageSize = sysconf(_SC_PAGE_SIZE);
+    if (pages <= 0 || pageSize <= 0)
+        return 0;
+    return static_cast<size_t>(pages) * static_cast<size_t>(pageSize);
+}
@@ -9,9 +9,12 @@
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/SetVector.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/BinaryFormat/Magic.h"
 #include "llvm/Bitcode/BitcodeReader.h"
 #include "llvm/Bitcode/BitcodeWriter.h"
 #include "llvm/IR/Constants.h"
+#include "llvm/IR/DiagnosticInfo.h"
+#include "llvm/IR/DiagnosticPrinter.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/GlobalValue.h"
 #include "llvm/IR/GlobalVariable.h"
@@ -21,16 +24,105 @@
 #include "llvm/IR/ValueMap.h" // ValueToValueMapTy 的详细定义
 #include "llvm/IR/Verifier.h"
 #include "llvm/IRReader/IRReader.h"
+#include "llvm/Linker/Linker.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/SmallVectorMemoryBuffer.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Transforms/Utils/Cloning.h" // 包含 CloneModule 和 ValueToValueMapTy
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstdlib>
 #include <queue>
 
 BCModuleSplitter::BCModuleSplitter(BCCommon &commonRef) : common(commonRef), verifier(commonRef) {
     // 构造符号初始化verifier时传入common
+    optimizer.setConfig(makeOptimizerConfig());
+}
+
+// 按优化放置模式配置分组模块的优化管道
+custom::OptimizerConfig BCModuleSplitter::makeOptimizerConfig() const {
+    custom::OptimizerConfig optimizerConfig = custom::OptimizerConfig::Default();
+    optimizerConfig.pre_link_only = config.optimizationPlacement == OptimizationPlacement::Linker;
+    optimizerConfig.pre_o2_pipeline = prePassPipeline;
+    optimizerConfig.post_o2_pipeline = postPassPipeline;
+    return optimizerConfig;
+}
+
+/**
+ * @brief 读取优化方案配置文件，按文件序号为每个非空分组确定方案
+ *
+ * 1到n号组对应Config::packageStrings中的包，0号为公共组。配置文件不存在时所有分组使用O2，
+ * 文件有误时报告出错的行并同样退回O2，不会只应用一部分规则。
+ */
+void BCModuleSplitter::assignOptimizationProfiles() {
+    profileTable.clear();
+    if (llvm::sys::fs::exists(config.optimizationProfileFile)) {
+        std::string error;
+        if (profileTable.load(config.optimizationProfileFile, error)) {
+            logger.log("读取优化方案配置: " + config.optimizationProfileFile + " (" +
+                       std::to_string(profileTable.getRuleCount()) + " 条分组规则)");
+        } else {
+            logger.logError("优化方案配置有误，所有分组使用O2: " + error);
+        }
+    }
+
+    const GroupTable &groupTable = common.getGroupTable();
+    fileProfiles.clear();
+    fileTelemetry.clear();
+    for (size_t groupId = 0; groupId < groupTable.getGroupCount(); groupId++) {
+        if (groupTable.members(groupId).empty())
+            continue;
+        llvm::StringRef packageName = groupId == 0 ? "" : llvm::StringRef(config.packageStrings[groupId - 1]);
+        fileProfiles.push_back(profileTable.select(groupId, packageName));
+        fileTelemetry.emplace_back();
+        std::string source =
+            groupId == 0 ? "公共组" : "group:" + std::to_string(groupId) + ", " + packageName.str();
+        logger.logToFile("组 {" + std::to_string(fileProfiles.size() - 1) + "} 优化方案: " +
+                         fileProfiles.back().getName() + " (" + source + ")");
+    }
+}
+
+const custom::OptimizationProfile &BCModuleSplitter::getFileProfile(int fileIndex) const {
+    static const custom::OptimizationProfile defaultProfile;
+    if (fileIndex < 0 || static_cast<size_t>(fileIndex) >= fileProfiles.size())
+        return defaultProfile;
+    return fileProfiles[fileIndex];
+}
+
+custom::OptimizationTelemetry *BCModuleSplitter::getFileTelemetry(int fileIndex) {
+    if (!config.passTimingReport || fileIndex < 0 || static_cast<size_t>(fileIndex) >= fileTelemetry.size())
+        return nullptr;
+    return &fileTelemetry[fileIndex];
+}
+
+// 主要优化留给链接时LTO时，按组的优化级别设置--lto-O；lld的LTO没有尺寸级别，Os/Oz按O2链接
+std::string BCModuleSplitter::getLinkerFlags(const custom::OptimizationProfile &profile) const {
+    switch (config.optimizationPlacement) {
+    case OptimizationPlacement::Splitter:
+        return config.splitterPlacementLinkerFlags;
+    case OptimizationPlacement::Linker:
+        if (profile.Pipeline.empty() && profile.Level.getSpeedupLevel() != 2)
+            return "--lto-O" + std::to_string(profile.Level.getSpeedupLevel());
+        return "";
+    default:
+        return "";
+    }
+}
+
+std::string BCModuleSplitter::getPlacementName(OptimizationPlacement placement) {
+    switch (placement) {
+    case OptimizationPlacement::Both:
+        return "Both(拆分器O2 + 链接时LTO)";
+    case OptimizationPlacement::Linker:
+        return "Linker(拆分器预链接管道 + 链接时LTO)";
+    case OptimizationPlacement::Splitter:
+        return "Splitter(拆分器O2 + 链接时只做代码生成)";
+    default:
+        return "Unknown";
+    }
 }
 
 // 获取链接属性字符串表示
@@ -78,28 +170,210 @@ void BCModuleSplitter::setCloneMode(bool enable) {
     logger.log("设置拆分模式: " + std::string(enable ? "CLONE_MODE" : "MANUAL_MODE"));
 }
 
+// 并行生成的优化器池在拆分时按同一配置创建，这里只需更新主优化器
+void BCModuleSplitter::setPassPipelines(const std::string &prePipeline, const std::string &postPipeline) {
+    prePassPipeline = prePipeline;
+    postPassPipeline = postPipeline;
+    optimizer.setConfig(makeOptimizerConfig());
+    if (!prePipeline.empty())
+        logger.log("O2之前运行: " + prePipeline);
+    if (!postPipeline.empty())
+        logger.log("O2之后运行: " + postPipeline);
+}
+
 bool BCModuleSplitter::loadBCFile(llvm::StringRef filename) {
     logger.log("加载BC文件: " + filename.str());
     llvm::SMDiagnostic err;
-    std::string newfilename = config.workSpace + "output/" + common.renameUnnamedGlobalValues(filename);
 
     // 创建新的上下文
     llvm::LLVMContext *context = new llvm::LLVMContext();
     common.setContext(context);
 
-    auto module = llvm::parseIRFile(newfilename, err, *context);
-    common.setModule(std::move(module));
+    // 惰性加载bitcode时以只读映射方式打开输入文件，函数体留在映射中直到被访问；
+    // 文本IR的词法分析依赖缓冲区末尾的'\0'，先按文件头判断类型，只有bitcode才省去结尾符
+    llvm::file_magic magic = llvm::file_magic::unknown;
+    bool mapWithoutTerminator = config.lazyLoadInput && !llvm::identify_magic(filename, magic) &&
+                                magic == llvm::file_magic::bitcode;
+    auto bufferOrErr = llvm::MemoryBuffer::getFile(filename, /*IsText=*/false,
+                                                   /*RequiresNullTerminator=*/!mapWithoutTerminator);
+    if (!bufferOrErr) {
+        logger.logError("无法打开BC文件: " + filename.str() + " - " + bufferOrErr.getError().message());
+        return false;
+    }
+    std::unique_ptr<llvm::MemoryBuffer> buffer = std::move(bufferOrErr.get());
+
+    if (config.analysisCache) {
+        common.setInputHash(AnalysisCache::hashContents(buffer->getBuffer()));
+    }
+
+    bool isBitcode = llvm::isBitcode(reinterpret_cast<const unsigned char *>(buffer->getBufferStart()),
+                                     reinterpret_cast<const unsigned char *>(buffer->getBufferEnd()));
+    if (isBitcode && config.symbolTablePrepass) {
+        planFromSymbolTable(buffer->getMemBufferRef());
+    }
+
+    if (isBitcode) {
+        auto modulesOrErr = llvm::getBitcodeModuleList(buffer->getMemBufferRef());
+        if (!modulesOrErr) {
+            logger.logError("无法读取BC文件中的模块列表: " + filename.str() + " - " +
+                            llvm::toString(modulesOrErr.takeError()));
+            return false;
+        }
+        if (modulesOrErr->size() > 1) {
+            std::unique_ptr<llvm::MemoryBuffer> merged = mergeBitcodeModules(*modulesOrErr, filename);
+            if (!merged)
+                return false;
+            buffer = std::move(merged);
+        }
+    }
+
+    if (isBitcode && config.lazyLoadInput) {
+        auto moduleOrErr = llvm::getLazyBitcodeModule(buffer->getMemBufferRef(), *context);
+        if (!moduleOrErr) {
+            logger.logError("无法惰性加载BC文件: " + filename.str() + " - " + llvm::toString(moduleOrErr.takeError()));
+            return false;
+        }
+        common.setInputBuffer(std::move(buffer));
+        common.setModule(std::move(moduleOrErr.get()));
+        logger.log("使用惰性加载模式，函数体按需物化");
+    } else {
+        // 文本IR无法惰性加载，退回完整解析
+        common.setModule(llvm::parseIR(buffer->getMemBufferRef(), err, *context));
+    }
 
     if (!common.hasModule()) {
-        logger.logError("无法加载BC文件: " + newfilename);
+        logger.logError("无法加载BC文件: " + filename.str());
         err.print("BCModuleSplitter", llvm::errs());
         return false;
     }
 
+    // 在已加载的模块上就地重命名无名全局对象，避免克隆和二次解析
+    unsigned renamedCount = BCCommon::renameUnnamedGlobalValues(*common.getModule());
+    logger.log("就地重命名无名全局对象: " + std::to_string(renamedCount) + " 个");
+
+    if (config.dumpRenamedBitcode) {
+        dumpRenamedBitcode(filename);
+    }
+
     logger.log("成功加载模块: " + common.getModule()->getModuleIdentifier());
     return true;
 }
 
+/**
+ * @brief 调试用：写出就地重命名后的完整模块
+ *
+ * 惰性加载的模块中函数体尚未物化，直接写出会丢失函数体；materializeAll又会丢弃物化器，
+ * 之后的按需物化和释放都无法进行。因此惰性加载时在独立的上下文中完整解析一份输入，
+ * 按同样的规则重命名后写出，随即释放。
+ */
+void BCModuleSplitter::dumpRenamedBitcode(llvm::StringRef filename) {
+    std::string dumpName = "renamed_" + filename.str();
+    if (!common.getInputBuffer()) {
+        common.writeBitcodeSafely(*common.getModule(), dumpName);
+        return;
+    }
+
+    llvm::LLVMContext dumpContext;
+    auto moduleOrErr = llvm::parseBitcodeFile(common.getInputBuffer()->getMemBufferRef(), dumpContext);
+    if (!moduleOrErr) {
+        logger.logError("无法解析输入以写出重命名后的模块: " + llvm::toString(moduleOrErr.takeError()));
+        return;
+    }
+    BCCommon::renameUnnamedGlobalValues(**moduleOrErr);
+    common.writeBitcodeSafely(**moduleOrErr, dumpName);
+}
+
+/**
+ * @brief 在解析IR之前，只读符号表给出各包的预分组规模
+ *
+ * 大输入上这一步不物化任何函数体，结果几乎立即可用；之后的完整分析只根据调用边修正。
+ * 读取失败不影响后续加载。
+ */
+void BCModuleSplitter::planFromSymbolTable(llvm::MemoryBufferRef buffer) {
+    PackageClassifier classifier(config.packageStrings);
+    std::string error;
+    if (!PreliminaryPlan::build(buffer, classifier, config.packageStrings.size(), preliminaryPlan, error)) {
+        logger.logWarning("无法读取bitcode符号表，跳过预分组: " + error);
+        preliminaryPlan = PreliminaryPlan();
+        return;
+    }
+
+    logger.log("符号表预分组: " + std::to_string(preliminaryPlan.moduleCount) + " 个模块, " +
+               std::to_string(preliminaryPlan.definedSymbols) + " 个有定义符号, " +
+               std::to_string(preliminaryPlan.undefinedSymbols) + " 个外部符号, " +
+               std::to_string(preliminaryPlan.definedSymbols - preliminaryPlan.unclassified) + " 个命中包名");
+    for (size_t i = 0; i < preliminaryPlan.packageSeeds.size(); i++) {
+        logger.logToFile("  预分组 " + std::to_string(i + 1) + " " + config.packageStrings[i] + ": " +
+                         std::to_string(preliminaryPlan.packageSeeds[i]) + " 个符号, 其中 " +
+                         std::to_string(preliminaryPlan.packageFunctions[i]) + " 个函数");
+    }
+    logger.logToFile("  预分组 公共组: " + std::to_string(preliminaryPlan.unclassified) + " 个未命中包名的符号");
+}
+
+/**
+ * @brief 把一个bitcode文件中的多个模块合并为单个模块的bitcode
+ *
+ * 与llvm-link相同，各模块惰性加载到临时上下文，由Linker按名字解析跨模块引用后依次并入一个空模块，
+ * 任何模块都不预先完整物化：函数体在被移入时才物化，没有被引用的局部符号不会被移入，
+ * 局部链接符号的重名由Linker改名处理。合并结果序列化到内存，作为新的输入缓冲区，
+ * 之后的惰性加载、按组物化和工作线程重载都与单模块输入相同。临时上下文在返回前释放。
+ *
+ * 注意内存峰值：合并在单线程中进行，被移入的函数体留在合并模块中，序列化时完整的合并IR和
+ * 它的bitcode副本同时存在。多模块输入因此在加载阶段失去惰性加载的好处，峰值约为整个程序的IR
+ * 加一份合并后的bitcode，之后的分组阶段才恢复按组物化。
+ *
+ * @return 合并后的bitcode，失败时返回nullptr
+ */
+std::unique_ptr<llvm::MemoryBuffer> BCModuleSplitter::mergeBitcodeModules(std::vector<llvm::BitcodeModule> &modules,
+                                                                          llvm::StringRef identifier) {
+    logger.log("输入包含 " + std::to_string(modules.size()) +
+               " 个模块，按名字解析跨模块引用后合并（被并入的函数体都会物化）");
+
+    llvm::LLVMContext mergeContext;
+    // Linker通过上下文报告符号冲突等错误，收集后统一记录，避免默认处理直接退出进程
+    std::string diagnostics;
+    mergeContext.setDiagnosticHandlerCallBack(
+        [](const llvm::DiagnosticInfo &DI, void *context) {
+            auto *messages = static_cast<std::string *>(context);
+            llvm::raw_string_ostream os(*messages);
+            llvm::DiagnosticPrinterRawOStream printer(os);
+            DI.print(printer);
+            os << "\n";
+        },
+        &diagnostics);
+
+    // 数据布局和目标三元组由Linker取自第一个并入的模块
+    auto composite = std::make_unique<llvm::Module>(identifier, mergeContext);
+    llvm::Linker linker(*composite);
+    for (size_t i = 0; i < modules.size(); i++) {
+        auto moduleOrErr = modules[i].getLazyModule(mergeContext, /*ShouldLazyLoadMetadata=*/true,
+                                                    /*IsImporting=*/false);
+        if (!moduleOrErr) {
+            logger.logError("无法惰性加载第 " + std::to_string(i) + " 个模块: " +
+                            llvm::toString(moduleOrErr.takeError()));
+            return nullptr;
+        }
+        std::unique_ptr<llvm::Module> M = std::move(moduleOrErr.get());
+        logger.logToFile("  模块 " + std::to_string(i) + ": " + M->getModuleIdentifier() + ", " +
+                         std::to_string(M->size()) + " 个函数, " + std::to_string(M->global_size()) + " 个全局变量");
+
+        if (linker.linkInModule(std::move(M))) {
+            logger.logError("合并第 " + std::to_string(i) + " 个模块失败:\n" + diagnostics);
+            return nullptr;
+        }
+    }
+    if (!diagnostics.empty())
+        logger.logToFile("合并模块时的诊断信息:\n" + diagnostics);
+
+    llvm::SmallVector<char, 0> bitcode;
+    BCCommon::serializeBitcode(*composite, bitcode);
+    logger.log("合并完成: " + std::to_string(composite->size()) + " 个函数, " +
+               std::to_string(composite->global_size()) + " 个全局变量, " + std::to_string(bitcode.size()) +
+               " 字节");
+    return std::make_unique<llvm::SmallVectorMemoryBuffer>(std::move(bitcode), identifier,
+                                                           /*RequiresNullTerminator=*/false);
+}
+
 void BCModuleSplitter::analyzeFunctions() {
     logger.log("开始分析符号调用关系...");
 
@@ -159,6 +433,9 @@ void BCModuleSplitter::analyzeFunctions() {
     logger.log("收集到 " + std::to_string(functionCount) + " 个符号定义");
     logger.log("其中无名符号数量: " + std::to_string(unnamedFunctionCount));
 
+    // 分配稠密符号ID，之后globalValueMap不再增删
+    common.assignSymbolIds();
+
     // 分析调用关系
     common.analyzeCallRelations();
     common.findCyclicGroups();
@@ -172,7 +449,7 @@ void BCModuleSplitter::printFunctionInfo() {
     for (const auto &pair : globalValueMap) {
         const auto &info = pair.second;
 
-        logger.logToFile(info.getFullInfo());
+        logger.logToFile(info.getFullInfo(common.getCallGraph(), common.getPersonalityGraph(), common.getSymbols()));
     }
 }
 
@@ -218,9 +495,9 @@ void BCModuleSplitter::generateGroupReport(llvm::StringRef outputPrefix) {
     // 定义所有可能的BC文件组
     report << "=== 分组详情 ===" << std::endl;
     int countFileMapIndex = 0;
-    auto &globalValuesAllGroups = common.getGlobalValuesAllGroups();
+    const GroupTable &groupTable = common.getGroupTable();
 
-    for (int groupId = 0; groupId < globalValuesAllGroups.size(); groupId++) {
+    for (size_t groupId = 0; groupId < groupTable.getGroupCount(); groupId++) {
         if (groupGlobalValues[groupId].empty())
             continue;
 
@@ -266,7 +543,7 @@ void BCModuleSplitter::generateGroupReport(llvm::StringRef outputPrefix) {
 
     // 新增：最终拆分完成后的BC文件链接属性和可见性报告
     report << "=== 最终拆分BC文件链接属性和可见性报告 ===" << std::endl << std::endl;
-    llvm::SmallVector<llvm::SmallSetVector<int, 32>, 32> dependendGroupInfo = common.getGroupDependencies();
+    const std::vector<EmissionRecord> &records = common.getEmissionRecords();
 
     // 检查每个BC文件并报告链接属性和可见性
     for (const auto &bcFileInfo : fileMap) {
@@ -280,63 +557,45 @@ void BCModuleSplitter::generateGroupReport(llvm::StringRef outputPrefix) {
         report << "文件: " << filename
                << (groupIndex == 0 ? "(公共组)" : "(字符匹配组<" + std::to_string(groupIndex) + ">)") << std::endl;
 
-        // 加载BC文件进行分析
-        llvm::LLVMContext tempContext;
-        llvm::SMDiagnostic err;
-        auto testModule = llvm::parseIRFile(pathPre + filename, err, tempContext);
-
-        if (!testModule) {
-            report << "  错误: 无法加载文件进行分析" << std::endl;
+        // 使用写出前采集的生成记录；paranoidReparse时重新加载BC文件进行分析
+        if (groupIndex < 0 || static_cast<size_t>(groupIndex) >= records.size() || !records[groupIndex].written) {
+            report << "  错误: 没有该文件的生成记录" << std::endl;
             continue;
         }
+        EmissionRecord reparsed;
+        const EmissionRecord *record = &records[groupIndex];
+        if (config.paranoidReparse) {
+            reparsed = *record;
+            if (!common.reparseEmissionRecord(reparsed)) {
+                report << "  错误: 无法加载文件进行分析" << std::endl;
+                continue;
+            }
+            record = &reparsed;
+        }
 
-        // 统计信息
-        AttributeStats globalVariableStatistics = AttributeStats();
-        AttributeStats functionStatistics = AttributeStats();
-
+        report << "  优化方案: " << record->optimizationProfile
+               << (record->linkerFlags.empty() ? "" : ", 链接参数: " + record->linkerFlags) << std::endl;
         report << "  符号分析:" << std::endl;
         int totalGV = 0;
-        int unnamedFIndex = 0;
-
-        for (auto &GVar : testModule->globals()) {
-            if (GVar.hasInitializer()) {
-                totalGV++;
-                GlobalValueInfo tempInfo(&GVar, unnamedFIndex);
-                report << "    " << totalGV << ", " << tempInfo.getBriefInfo() << std::endl;
-
-                // 统计链接属性
-                globalVariableStatistics.addInfo(tempInfo);
-            }
+        for (const std::string &brief : record->symbolBriefs) {
+            report << "    " << ++totalGV << ", " << brief << std::endl;
         }
 
-        for (llvm::Function &F : *testModule) {
-            if (!F.isDeclaration()) {
-                totalGV++;
-                GlobalValueInfo tempInfo(&F, unnamedFIndex);
-                report << "    " << totalGV << ", " << tempInfo.getBriefInfo() << std::endl;
+        if (record->hasKonanCxaDemangle)
+            fileMap[groupIndex]->hasKonanCxaDemangle = true;
 
-                // 统计链接属性
-                functionStatistics.addInfo(tempInfo);
-
-                if (tempInfo.displayName == "Konan_cxa_demangle")
-                    fileMap[groupIndex]->hasKonanCxaDemangle = true;
-            }
-        }
-        for (int dependGroupIndex : dependendGroupInfo[groupIndex]) {
+        for (int dependGroupIndex : record->dependencies) {
             report << "  组[" << groupIndex << "]依赖组[" << dependGroupIndex << "]" << std::endl;
             fileMap[groupIndex]->dependencies.insert(dependGroupIndex);
         }
 
         report << "  总计: " << totalGV << " 个符号" << std::endl;
 
-        // 验证模块
-        std::string verifyResult;
-        llvm::raw_string_ostream rso(verifyResult);
-        bool moduleValid = !verifyModule(*testModule, &rso);
-        report << "  模块验证: " << (moduleValid ? "通过" : "失败") << std::endl;
+        // 验证结果
+        report << "  模块验证: " << (record->moduleValid ? "通过" : "失败") << std::endl;
 
-        if (!moduleValid) {
-            report << "  验证错误: " << rso.str() << std::endl;
+        if (!record->moduleValid) {
+            report << "  验证错误: " << record->verifyErrors << std::endl;
         }
 
         report << std::endl;
@@ -376,148 +635,145 @@ void BCModuleSplitter::generateGroupReport(llvm::StringRef outputPrefix) {
     for (const auto &file : existingFiles) {
         logger.log("  - " + file);
     }
-}
-
-void BCModuleSplitter::getGlobalValueGroup(int groupIndex) {
-    llvm::DenseSet<llvm::GlobalValue *> group;
-    auto &globalValueMap = common.getGlobalValueMap();
 
-    const auto packageString = config.packageStrings[groupIndex - 1];
-
-    // 1. 遍历globalValueMap，找出displayName包含packageString的GlobalValue
-    for (auto &[GV, info] : globalValueMap) {
-        if (!GV || info.preGroupIndex == 0) {
-            continue;
-        }
+    if (config.passTimingReport)
+        writeOptimizationReport(outputPrefix);
+}
 
-        // 检查displayName是否包含packageString
-        if (info.displayName.find(packageString) != std::string::npos)
-            group.insert(GV);
+/**
+ * @brief 把各组的优化遥测写成JSON，与分组报告放在同一目录
+ *
+ * 每组给出优化方案、墙钟和CPU总耗时、优化前后及过程中的最大指令数，
+ * 以及按墙钟时间降序的每个Pass和分析的自身耗时，用于判断哪些组值得换用更轻的管道。
+ */
+void BCModuleSplitter::writeOptimizationReport(llvm::StringRef outputPrefix) {
+    std::string reportFile = outputPrefix.str() + "_optimization_report.json";
+    std::error_code ec;
+    llvm::raw_fd_ostream out(config.workSpace + "logs/" + reportFile, ec);
+    if (ec) {
+        logger.logError("无法创建优化报告文件: " + reportFile + " - " + ec.message());
+        return;
     }
 
-    // 2. 通过getOriginWithOutDegreeGlobalValues进行扩展
-    group = getOriginWithOutDegreeGlobalValues(groupIndex, group);
-
-    // 3. 通过getStronglyConnectedComponent进行补充
-    group = getStronglyConnectedComponent(groupIndex, group);
-
-    // 4. 对group中的每个成员标记preGroupIndex和isPreProcessed
-    for (llvm::GlobalValue *GV : group) {
-        if (GV && globalValueMap.count(GV)) {
-            globalValueMap[GV].isPreProcessed = true;
-        }
-    }
+    const std::vector<EmissionRecord> &records = common.getEmissionRecords();
+    llvm::json::OStream json(out, 2);
+    json.object([&]() {
+        json.attribute("placement", getPlacementName(config.optimizationPlacement));
+        json.attribute("totalOptimizationMs", optimizationMicros.load() / 1000.0);
+        json.attributeArray("groups", [&]() {
+            for (size_t fileIndex = 0; fileIndex < fileTelemetry.size(); fileIndex++) {
+                const custom::OptimizationTelemetry &telemetry = fileTelemetry[fileIndex];
+                if (telemetry.isEmpty())
+                    continue;
+                json.object([&]() {
+                    json.attribute("fileIndex", static_cast<int64_t>(fileIndex));
+                    if (fileIndex < records.size())
+                        json.attribute("file", records[fileIndex].filename);
+                    json.attribute("profile", telemetry.Profile);
+                    json.attribute("wallMs", telemetry.WallMs);
+                    json.attribute("cpuMs", telemetry.CpuMs);
+                    json.attribute("instructionsBefore", static_cast<int64_t>(telemetry.InstructionsBefore));
+                    json.attribute("instructionsAfter", static_cast<int64_t>(telemetry.InstructionsAfter));
+                    json.attribute("peakInstructions", static_cast<int64_t>(telemetry.PeakInstructions));
+                    json.attributeArray("passes", [&]() {
+                        for (const custom::PassTiming &pass : telemetry.Passes) {
+                            json.object([&]() {
+                                json.attribute("name", pass.Name);
+                                json.attribute("kind", pass.IsAnalysis ? "analysis" : "pass");
+                                json.attribute("runs", static_cast<int64_t>(pass.Runs));
+                                json.attribute("wallMs", pass.WallMs);
+                                json.attribute("cpuMs", pass.CpuMs);
+                            });
+                        }
+                    });
+                });
+            }
+        });
+    });
+    out << "\n";
+    logger.log("优化报告已生成: " + reportFile);
 }
 
-llvm::DenseSet<llvm::GlobalValue *>
-BCModuleSplitter::getOriginWithOutDegreeGlobalValues(int preGroupId,
-                                                     const llvm::DenseSet<llvm::GlobalValue *> &originGVs) {
-    llvm::DenseSet<llvm::GlobalValue *> completeSet;
-    llvm::SmallVector<llvm::GlobalValue *, 32> toProcess;
-    auto &globalValueMap = common.getGlobalValueMap();
-
-    // 初始添加所有符号
-    for (llvm::GlobalValue *GV : originGVs) {
-        if (!GV || globalValueMap[GV].preGroupIndex == 0)
-            continue;
-        completeSet.insert(GV);
-        toProcess.push_back(GV);
-        globalValueMap[GV].preGroupIndex = globalValueMap[GV].isPreProcessed ? 0 : preGroupId;
+/**
+ * @brief 用所有包名构建一个Aho–Corasick自动机，一次扫描完成全部符号的包归属
+ *
+ * 所有displayName以'\0'分隔拼接到一段连续缓冲区中顺序扫描。
+ * 一个符号匹配多个包时（如 androidx.compose.foundation 与 androidx.compose.foundation.text），
+ * 取最长的包名；等长时取packageStrings中靠前的一个。
+ * 有符号表预分组时，按包对比两者的种子数，差异来自符号表中没有的局部符号和重命名的无名符号。
+ */
+void BCModuleSplitter::classifyPackageSymbols() {
+    llvm::ArrayRef<GlobalValueInfo *> symbolInfos = common.getSymbolInfos();
+    packageMembers.assign(config.packageStrings.size(), {});
+
+    PackageClassifier classifier(config.packageStrings);
+    std::vector<llvm::StringRef> names;
+    names.reserve(symbolInfos.size());
+    for (const GlobalValueInfo *info : symbolInfos) {
+        names.push_back(info->displayName);
     }
+    std::vector<int> packageOf = classifier.classify(names);
 
-    if (toProcess.empty()) {
-        return originGVs;
+    size_t classifiedCount = 0;
+    for (SymbolId id = 0; id < symbolInfos.size(); id++) {
+        if (packageOf[id] == PackageClassifier::Unclassified)
+            continue;
+        packageMembers[packageOf[id]].push_back(id);
+        classifiedCount++;
     }
 
-    // 广度优先遍历所有出度符号
-    size_t frontIndex = 0;
-    while (frontIndex < toProcess.size()) {
-        llvm::GlobalValue *current = toProcess[frontIndex];
-        frontIndex++;
-
-        // 获取当前符号的所有出度符号
-        const GlobalValueInfo &info = globalValueMap[current];
-        for (llvm::GlobalValue *called : info.calleds) {
-            if (!called || globalValueMap[called].preGroupIndex == 0)
-                continue;
-
-            if (globalValueMap[called].isPreProcessed) {
-                completeSet.insert(called);
-                toProcess.push_back(called);
-                globalValueMap[called].preGroupIndex = 0;
-                continue;
-            }
+    logger.log("包名匹配完成: " + std::to_string(config.packageStrings.size()) + " 个包, " +
+               std::to_string(classifier.getStateCount()) + " 个自动机状态, " + std::to_string(classifiedCount) +
+               " 个符号命中");
 
-            // 如果符号不在集合中，添加到集合和队列
-            if (!completeSet.contains(called)) {
-                completeSet.insert(called);
-                toProcess.push_back(called);
-                globalValueMap[called].preGroupIndex = info.preGroupIndex;
-            }
+    if (preliminaryPlan.packageSeeds.size() != packageMembers.size())
+        return;
+    for (size_t i = 0; i < packageMembers.size(); i++) {
+        if (packageMembers[i].size() != preliminaryPlan.packageSeeds[i]) {
+            logger.logToFile("预分组修正: " + config.packageStrings[i] + " " +
+                             std::to_string(preliminaryPlan.packageSeeds[i]) + " -> " +
+                             std::to_string(packageMembers[i].size()) + " 个种子符号");
         }
     }
-
-    return completeSet;
 }
 
-llvm::DenseSet<llvm::GlobalValue *>
-BCModuleSplitter::getStronglyConnectedComponent(int preGroupId, const llvm::DenseSet<llvm::GlobalValue *> &originGVs) {
-    llvm::DenseSet<llvm::GlobalValue *> completeSet;
-
-    // 使用 SmallVector 模拟队列
-    llvm::SmallVector<llvm::GlobalValue *, 32> toProcess;
-
-    auto &globalValueMap = common.getGlobalValueMap();
-
-    // 初始添加符号
-    for (llvm::GlobalValue *GV : originGVs) {
-        if (!GV || globalValueMap[GV].preGroupIndex == 0)
-            continue;
-        completeSet.insert(GV);
-        toProcess.push_back(GV);
-        globalValueMap[GV].preGroupIndex = globalValueMap[GV].isPreProcessed ? 0 : preGroupId;
-    }
-
-    if (toProcess.empty()) {
-        return originGVs;
+/**
+ * @brief 一次性为所有符号标记所属的包分组
+ *
+ * 每个包的种子为classifyPackageSymbols按最长匹配分到的符号。沿调用方向（含循环调用组）
+ * 只被一个包到达的符号归入该包；被多个包共同到达的符号，以及没有包到达的符号归入公共组。
+ * 可达性在SCC缩点DAG上按拓扑序一次传播得到，不再为每个包单独做BFS。
+ */
+void BCModuleSplitter::labelPackageGroups() {
+    llvm::ArrayRef<GlobalValueInfo *> symbolInfos = common.getSymbolInfos();
+
+    std::vector<int> seedLabels(symbolInfos.size(), SCCGraph::NoLabel);
+    for (size_t i = 0; i < packageMembers.size(); i++) {
+        for (SymbolId id : packageMembers[i]) {
+            seedLabels[id] = static_cast<int>(i) + 1; // 组号从1开始
+        }
     }
 
-    // 广度优先遍历所有依赖循环
-    size_t frontIndex = 0; // 模拟队列的队首索引
-    while (frontIndex < toProcess.size()) {
-        llvm::GlobalValue *current = toProcess[frontIndex];
-        frontIndex++;
-
-        // 获取当前符号的所有循环依赖组
-        llvm::DenseSet<llvm::GlobalValue *> cyclicGVs = common.getCyclicGroupsContainingGlobalValue(current);
+    std::vector<int> labels = common.getSCCGraph().propagateUniqueLabels(seedLabels);
 
-        for (llvm::GlobalValue *cyc : cyclicGVs) {
-            if (!cyc || globalValueMap[cyc].preGroupIndex == 0)
-                continue;
-
-            if (globalValueMap[cyc].isPreProcessed) {
-                completeSet.insert(cyc);
-                toProcess.push_back(cyc);
-                globalValueMap[cyc].preGroupIndex = 0;
-                continue;
-            }
-
-            // 如果符号不在集合中，添加到集合和队列
-            if (!completeSet.contains(cyc)) {
-                completeSet.insert(cyc);
-                toProcess.push_back(cyc);
-                globalValueMap[cyc].preGroupIndex = globalValueMap[current].preGroupIndex;
-            }
-        }
+    size_t conflictCount = 0;
+    for (SymbolId id = 0; id < symbolInfos.size(); id++) {
+        if (labels[id] == SCCGraph::NoLabel)
+            continue;
+        if (labels[id] == SCCGraph::ConflictLabel)
+            conflictCount++;
+        symbolInfos[id]->preGroupIndex = labels[id] > 0 ? labels[id] : 0;
+        symbolInfos[id]->isPreProcessed = true;
     }
 
-    return completeSet;
+    logger.log("包可达性标记完成: " + std::to_string(conflictCount) + " 个符号被多个包共同到达，归入公共组");
 }
 
 // 新增：统一的BC文件创建入口，支持两种模式
-bool BCModuleSplitter::createBCFile(const llvm::DenseSet<llvm::GlobalValue *> &group, llvm::StringRef filename,
-                                    int groupIndex) {
+bool BCModuleSplitter::createBCFile(llvm::ArrayRef<SymbolId> group, llvm::StringRef filename, int groupIndex) {
     if (BCModuleSplitter::currentMode == CLONE_MODE) {
+        if (config.selectiveExtraction)
+            return createBCFileWithExtraction(group, filename, groupIndex);
         return createBCFileWithClone(group, filename, groupIndex);
     } else {
         logger.log("已不支持此功能...");
@@ -532,76 +788,123 @@ void BCModuleSplitter::splitBCFiles(llvm::StringRef outputPrefix) {
 
     int fileCount = 0;
     auto &globalValueMap = common.getGlobalValueMap();
-    auto &globalValuesAllGroups = common.getGlobalValuesAllGroups();
-
-    llvm::DenseSet<llvm::GlobalValue *> publicGroup;
-    globalValuesAllGroups.push_back(publicGroup);
-
-    // 1. 处理第1到第n组（对应packageStrings）
-    for (size_t i = 0; i < config.packageStrings.size(); ++i) {
-        int groupIndex = i + 1;          // 组号从1开始
-        getGlobalValueGroup(groupIndex); // 获取当前包对应的组
-        llvm::DenseSet<llvm::GlobalValue *> group;
-        globalValuesAllGroups.push_back(group);
-    }
+    llvm::ArrayRef<GlobalValueInfo *> symbolInfos = common.getSymbolInfos();
 
-    // 2. 收集GlobalValue
-    for (auto &[GV, info] : globalValueMap) {
-        if (!GV) {
-            continue;
-        }
+    // 1. 处理第1到第n组（对应packageStrings），0号为公共组
+    classifyPackageSymbols();
+    labelPackageGroups();
 
-        if (info.isPreProcessed) {
-            globalValuesAllGroups[info.preGroupIndex].insert(GV);
-        } else {
-            globalValuesAllGroups[0].insert(GV);
+    // 2. 收集每个符号的分组号，构建分组表
+    std::vector<int> groupOfSymbol(symbolInfos.size(), 0);
+    for (SymbolId id = 0; id < symbolInfos.size(); id++) {
+        GlobalValueInfo &info = *symbolInfos[id];
+        if (!info.isPreProcessed) {
             info.preGroupIndex = 0;
             info.isPreProcessed = true;
         }
+        groupOfSymbol[id] = info.preGroupIndex;
     }
+    common.buildGroupTable(std::move(groupOfSymbol), config.packageStrings.size() + 1);
+    const GroupTable &groupTable = common.getGroupTable();
 
     // 步骤4: 按照指定数量范围分组
     logger.log("根据分组生成bc文件...");
 
-    // 持续分组直到所有符号都处理完
-    for (int groupId = 0; groupId < globalValuesAllGroups.size(); groupId++) {
-        llvm::DenseSet<llvm::GlobalValue *> completeGroup = globalValuesAllGroups[groupId];
+    // 每个非空分组一条生成记录，以文件序号为下标，生成期间不再改变大小
+    size_t nonEmptyGroups = 0;
+    for (size_t groupId = 0; groupId < groupTable.getGroupCount(); groupId++) {
+        if (!groupTable.members(groupId).empty())
+            nonEmptyGroups++;
+    }
+    common.getEmissionRecords().assign(nonEmptyGroups, EmissionRecord());
+    assignOptimizationProfiles();
+
+    unsigned emissionThreads = BCCommon::resolveThreadCount(config.emissionThreads);
+    bool parallelEmission = currentMode == CLONE_MODE && config.selectiveExtraction && emissionThreads > 1;
+    if (parallelEmission && !common.getInputBuffer()) {
+        logger.logWarning("输入不是惰性加载的bitcode，工作线程无法重新加载，改为串行生成");
+        parallelEmission = false;
+    }
 
-        if (completeGroup.empty())
-            continue;
-        logger.log("处理组 {" + std::to_string(fileCount) + "} 包含 " + std::to_string(completeGroup.size()) +
-                   " 个符号");
+    // paranoidReparse需要在每组生成后立即从磁盘读回，此时同步写出
+    const size_t MB = 1024 * 1024;
+    if (config.asyncWriteQueueMB > 0 && !config.paranoidReparse) {
+        outputWriter = std::make_unique<AsyncFileWriter>(config.asyncWriteQueueMB * MB);
+    }
 
-        // 创建BC文件
-        std::string filename =
-            outputPrefix.str() + (fileCount == 0 ? "_publicGroup.bc" : "_group_" + std::to_string(fileCount) + ".bc");
-
-        if (createBCFile(completeGroup, filename, fileCount)) {
-            // 验证并修复生成的BC文件
-            bool verified = false;
-            if (BCModuleSplitter::currentMode == CLONE_MODE) {
-                if (quickValidateBCFile(filename)) {
-                    verified = true;
-                    logger.log("✓ Clone模式分组BC文件验证通过: " + filename);
+    if (parallelEmission) {
+        fileCount = emitGroupsInParallel(outputPrefix, emissionThreads);
+    } else {
+        // 克隆整个模块需要完整的函数体，惰性加载时在此一次性物化；选择性抽取按组物化
+        if (!config.selectiveExtraction && !common.materializeModule()) {
+            logger.logError("✗ 无法物化输入模块，停止拆分");
+            outputWriter.reset();
+            return;
+        }
+
+        // 持续分组直到所有符号都处理完
+        // 文件序号为非空分组的序号，与生成记录、优化方案的下标一致，不受前面分组成败的影响
+        int fileIndex = 0;
+        for (size_t groupId = 0; groupId < groupTable.getGroupCount(); groupId++) {
+            llvm::ArrayRef<SymbolId> completeGroup = groupTable.members(groupId);
+
+            if (completeGroup.empty())
+                continue;
+            logger.log("处理组 {" + std::to_string(fileIndex) + "} 包含 " + std::to_string(completeGroup.size()) +
+                       " 个符号");
+
+            // 创建BC文件
+            std::string filename =
+                outputPrefix.str() + (fileIndex == 0 ? "_publicGroup.bc" : "_group_" + std::to_string(fileIndex) + ".bc");
+
+            if (createBCFile(completeGroup, filename, fileIndex)) {
+                // 验证并修复生成的BC文件
+                bool verified = false;
+                if (BCModuleSplitter::currentMode == CLONE_MODE) {
+                    if (validateEmittedFile(fileIndex)) {
+                        verified = true;
+                        logger.log("✓ Clone模式分组BC文件验证通过: " + filename);
+                    }
+                } else {
+                    logger.log("已不支持此功能...");
                 }
+
+                if (!verified) {
+                    logger.logError("✗ BC文件验证失败: " + filename);
+                }
+
+                fileCount++;
             } else {
-                logger.log("已不支持此功能...");
+                logger.logError("✗ 创建BC文件失败: " + filename);
             }
+            fileIndex++;
+        }
+    }
 
-            if (!verified) {
-                logger.logError("✗ BC文件验证失败: " + filename);
+    if (outputWriter) {
+        outputWriter->drain();
+        logger.logToFile("写盘队列峰值 " + std::to_string(outputWriter->getPeakQueuedBytes() / MB) + " MB");
+        outputWriter.reset();
+        for (const EmissionRecord &record : common.getEmissionRecords()) {
+            if (record.bitcodeBytes > 0 && !record.written) {
+                logger.logError("✗ BC文件写盘失败: " + record.filename);
             }
-
-            fileCount++;
-        } else {
-            logger.logError("✗ 创建BC文件失败: " + filename);
         }
     }
 
     totalGroups = fileCount;
 
+    // 分组之间的依赖只取决于分析结果，生成完成后一次性计算并记入生成记录
+    llvm::SmallVector<llvm::SmallSetVector<int, 32>, 32> groupDependencies = common.getGroupDependencies();
+    for (EmissionRecord &record : common.getEmissionRecords()) {
+        if (record.fileIndex >= 0 && static_cast<size_t>(record.fileIndex) < groupDependencies.size())
+            record.dependencies = groupDependencies[record.fileIndex];
+    }
+
     logger.log("\n=== 拆分完成 ===");
     logger.log("共生成 " + std::to_string(fileCount) + " 个分组BC文件");
+    logger.log("优化放置: " + getPlacementName(config.optimizationPlacement) + ", 拆分器优化累计耗时 " +
+               std::to_string(optimizationMicros.load() / 1000) + " ms");
     logger.log("使用模式: " + std::string(BCModuleSplitter::currentMode == CLONE_MODE ? "CLONE_MODE" : "MANUAL_MODE"));
 
     // 统计处理情况
@@ -622,7 +925,7 @@ void BCModuleSplitter::splitBCFiles(llvm::StringRef outputPrefix) {
         for (const auto &pair : globalValueMap) {
             if (!pair.second.isProcessed) {
                 const GlobalValueInfo &info = pair.second;
-                logger.logToFile(info.getFullInfo());
+                logger.logToFile(info.getFullInfo(common.getCallGraph(), common.getPersonalityGraph(), common.getSymbols()));
             }
         }
         logger.logToFile("未处理符号统计: 共 " + std::to_string(unprocessedCount) + " 个符号");
@@ -630,7 +933,7 @@ void BCModuleSplitter::splitBCFiles(llvm::StringRef outputPrefix) {
 }
 
 // 新增：使用LLVM CloneModule创建BC文件
-bool BCModuleSplitter::createBCFileWithClone(const llvm::DenseSet<llvm::GlobalValue *> &group, llvm::StringRef filename,
+bool BCModuleSplitter::createBCFileWithClone(llvm::ArrayRef<SymbolId> group, llvm::StringRef filename,
                                              int groupIndex) {
     logger.logToFile("使用Clone模式创建BC文件: " + filename.str() + " (组 " + std::to_string(groupIndex) + ")");
 
@@ -639,7 +942,9 @@ bool BCModuleSplitter::createBCFileWithClone(const llvm::DenseSet<llvm::GlobalVa
     llvm::DenseSet<llvm::GlobalValue *> newExternalGroup;
     llvm::DenseSet<llvm::GlobalValue *> newGroup;
     llvm::Module *M = common.getModule();
-    auto &globalValueMap = common.getGlobalValueMap();
+    llvm::ArrayRef<llvm::GlobalValue *> symbols = common.getSymbols();
+    llvm::ArrayRef<GlobalValueInfo *> symbolInfos = common.getSymbolInfos();
+    const GroupTable &groupTable = common.getGroupTable();
     auto newM = CloneModule(*M, vmap);
 
     if (!newM) {
@@ -650,16 +955,17 @@ bool BCModuleSplitter::createBCFileWithClone(const llvm::DenseSet<llvm::GlobalVa
     // 设置模块名称
     newM->setModuleIdentifier("cloned_group_" + std::to_string(groupIndex));
 
-    for (llvm::GlobalValue *orig : group) {
+    for (SymbolId id : group) {
+        llvm::GlobalValue *orig = symbols[id];
         // 查找原始符号在vmap中对应的新符号
         auto it = vmap.find(orig);
         if (it != vmap.end()) {
             // 确保映射到的是GlobalValue类型
             if (llvm::GlobalObject *newGV = llvm::dyn_cast<llvm::GlobalObject>(it->second)) {
-                if (!GlobalValueInfo::areAllCallersInGroup(orig, group, globalValueMap)) {
+                // 被组外调用的符号需要对外可见（分组表中预先算好）
+                if (groupTable.isExported(id)) {
                     newExternalGroup.insert(newGV);
-                    const auto &info = globalValueMap[orig];
-                    logger.logToFile("需要使用外部链接: " + info.displayName);
+                    logger.logToFile("需要使用外部链接: " + symbolInfos[id]->displayName);
                 }
                 newGroup.insert(newGV);
             } else {
@@ -679,21 +985,260 @@ bool BCModuleSplitter::createBCFileWithClone(const llvm::DenseSet<llvm::GlobalVa
     processClonedModuleGlobalValues(*newM, newGroup, newExternalGroup);
 
     // 标记原始符号已处理
-    for (llvm::GlobalValue *orig : group) {
-        if (globalValueMap.count(orig)) {
-            globalValueMap[orig].groupIndex = groupIndex;
-            globalValueMap[orig].isProcessed = true;
-        }
+    for (SymbolId id : group) {
+        symbolInfos[id]->groupIndex = groupIndex;
+        symbolInfos[id]->isProcessed = true;
     }
 
     logger.logToFile("Clone模式完成: " + filename.str() + " (包含 " + std::to_string(group.size()) + " 个符号)");
 
-    if (!runOptimizationAndVerify(*newM)) {
+    if (!runOptimizationAndVerify(*newM, optimizer, getFileProfile(groupIndex), getFileTelemetry(groupIndex))) {
+        logger.logError("✗ 编译优化失败");
+        return false;
+    }
+
+    return writeGroupModule(*newM, filename, groupIndex);
+}
+
+/**
+ * @brief 在写出之前采集生成记录，然后写出模块
+ *
+ * 调用前模块已通过runOptimizationAndVerify的验证，记录中的验证结果即来自这一次；
+ * 之后的批量验证和分组报告都读取该记录，不再重新解析输出文件。
+ * 有写盘线程时只序列化并提交，返回时文件可能尚未落盘，record.written在写盘完成后设置。
+ */
+bool BCModuleSplitter::writeGroupModule(llvm::Module &M, llvm::StringRef filename, int groupIndex) {
+    EmissionRecord &record = common.getEmissionRecords()[groupIndex];
+    record = EmissionRecord();
+    record.fileIndex = groupIndex;
+    record.filename = filename.str();
+    record.optimizationProfile = getFileProfile(groupIndex).getName();
+    record.linkerFlags = getLinkerFlags(getFileProfile(groupIndex));
+    BCCommon::captureModuleSummary(M, record);
+    record.moduleValid = true;
+
+    llvm::SmallVector<char, 0> buffer;
+    BCCommon::serializeBitcode(M, buffer);
+    record.bitcodeBytes = buffer.size();
+    if (!outputWriter) {
+        record.written = common.writeBitcodeSafely(buffer, filename);
+        return record.written;
+    }
+
+    // 交给写盘线程，模块和上下文随即可以释放
+    logger.logToFile("✓ 提交异步写盘: " + filename.str() + " (" + std::to_string(buffer.size()) + " 字节)");
+    outputWriter->submit(config.workSpace + "output/" + filename.str(), std::move(buffer),
+                         [&record](bool ok) { record.written = ok; });
+    return true;
+}
+
+// 检查刚生成的文件：默认使用写出前的验证结果，paranoidReparse时从磁盘重新解析验证；
+// 异步写出时文件可能还在写盘队列中，写盘失败在队列排空后单独报告
+bool BCModuleSplitter::validateEmittedFile(int fileIndex) {
+    const EmissionRecord &record = common.getEmissionRecords()[fileIndex];
+    if (config.paranoidReparse)
+        return quickValidateBCFile(record.filename);
+    return record.bitcodeBytes > 0 && record.moduleValid;
+}
+
+/**
+ * @brief 只抽取组内符号生成BC文件
+ *
+ * 由GroupExtractor把组内定义克隆到新模块，组外引用只生成声明。
+ * 惰性加载时只物化本组的函数体，抽取完成后立即丢弃，内存占用与单组大小成正比。
+ */
+bool BCModuleSplitter::createBCFileWithExtraction(llvm::ArrayRef<SymbolId> group, llvm::StringRef filename,
+                                                  int groupIndex) {
+    return emitGroup(*common.getModule(), common.getSymbols(), optimizer, group, filename, groupIndex);
+}
+
+/**
+ * @brief 从给定的源模块抽取、优化并写出一组
+ *
+ * 源模块可以是主上下文中的输入模块，也可以是并行生成时工作线程自己加载的副本；
+ * sourceSymbols以符号ID为下标给出源模块中对应的全局对象。除标记组内符号已处理外，
+ * 不修改分析结果，不同的组可以在各自的上下文中并发调用。
+ */
+bool BCModuleSplitter::emitGroup(llvm::Module &source, llvm::ArrayRef<llvm::GlobalValue *> sourceSymbols,
+                                 custom::CustomOptimizer &groupOptimizer, llvm::ArrayRef<SymbolId> group,
+                                 llvm::StringRef filename, int groupIndex) {
+    logger.logToFile("使用抽取模式创建BC文件: " + filename.str() + " (组 " + std::to_string(groupIndex) + ")");
+
+    llvm::ArrayRef<GlobalValueInfo *> symbolInfos = common.getSymbolInfos();
+    const GroupTable &groupTable = common.getGroupTable();
+
+    std::vector<llvm::GlobalValue *> definitions;
+    std::vector<llvm::GlobalValue *> exported;
+    llvm::SmallVector<llvm::Function *, 32> materialized;
+    definitions.reserve(group.size());
+
+    auto dematerializeAll = [&]() {
+        for (llvm::Function *F : materialized) {
+            BCCommon::dematerializeFunction(*F);
+        }
+    };
+
+    for (SymbolId id : group) {
+        llvm::GlobalValue *GV = sourceSymbols[id];
+        if (auto *F = llvm::dyn_cast<llvm::Function>(GV); F && F->isMaterializable()) {
+            if (!common.materializeFunction(*F)) {
+                dematerializeAll();
+                return false;
+            }
+            materialized.push_back(F);
+        }
+
+        definitions.push_back(GV);
+        // 被组外调用的符号需要对外可见（分组表中预先算好）
+        if (groupTable.isExported(id)) {
+            exported.push_back(GV);
+            logger.logToFile("需要使用外部链接: " + symbolInfos[id]->displayName);
+        }
+    }
+
+    GroupExtractor extractor(source);
+    std::unique_ptr<llvm::Module> newM =
+        extractor.extract(definitions, exported, "cloned_group_" + std::to_string(groupIndex));
+    dematerializeAll();
+
+    // 标记原始符号已处理
+    for (SymbolId id : group) {
+        symbolInfos[id]->groupIndex = groupIndex;
+        symbolInfos[id]->isProcessed = true;
+    }
+
+    logger.logToFile("抽取完成: " + filename.str() + " (包含 " + std::to_string(group.size()) + " 个符号, 新模块 " +
+                     std::to_string(newM->size()) + " 个函数, " + std::to_string(newM->global_size()) +
+                     " 个全局变量)");
+
+    if (!runOptimizationAndVerify(*newM, groupOptimizer, getFileProfile(groupIndex),
+                                  getFileTelemetry(groupIndex))) {
         logger.logError("✗ 编译优化失败");
         return false;
     }
 
-    return common.writeBitcodeSafely(*newM, filename);
+    return writeGroupModule(*newM, filename, groupIndex);
+}
+
+/**
+ * @brief 为并行生成的一个分组创建私有的上下文和源模块
+ *
+ * 在独立的LLVMContext中从共享的只读输入缓冲区惰性加载模块，按与主模块相同的规则重命名，
+ * 再按analyzeFunctions/assignSymbolIds的顺序（先全局变量，后有定义的函数）建立符号ID映射。
+ * 映射与分析结果不一致时返回nullptr。
+ */
+std::unique_ptr<BCModuleSplitter::EmissionContext> BCModuleSplitter::createEmissionContext() {
+    auto emission = std::make_unique<EmissionContext>();
+    auto moduleOrErr = llvm::getLazyBitcodeModule(common.getInputBuffer()->getMemBufferRef(), emission->context);
+    if (!moduleOrErr) {
+        logger.logError("工作线程无法惰性加载输入模块: " + llvm::toString(moduleOrErr.takeError()));
+        return nullptr;
+    }
+    emission->module = std::move(moduleOrErr.get());
+    BCCommon::renameUnnamedGlobalValues(*emission->module);
+
+    llvm::ArrayRef<llvm::GlobalValue *> symbols = common.getSymbols();
+    emission->symbols.reserve(symbols.size());
+    for (llvm::GlobalVariable &GVar : emission->module->globals()) {
+        emission->symbols.push_back(&GVar);
+    }
+    for (llvm::Function &F : *emission->module) {
+        if (!F.isDeclaration())
+            emission->symbols.push_back(&F);
+    }
+
+    if (emission->symbols.size() != symbols.size()) {
+        logger.logError("工作线程模块的符号数与分析结果不一致: " + std::to_string(emission->symbols.size()) + " / " +
+                        std::to_string(symbols.size()));
+        return nullptr;
+    }
+    for (size_t id = 0; id < symbols.size(); id++) {
+        if (emission->symbols[id]->getName() != symbols[id]->getName()) {
+            logger.logError("工作线程模块的符号顺序与分析结果不一致: " + symbols[id]->getName().str());
+            return nullptr;
+        }
+    }
+    return emission;
+}
+
+/**
+ * @brief 多线程生成所有分组的BC文件
+ *
+ * 每个分组在自己的LLVMContext中加载一份惰性模块，只物化本组的函数体，
+ * 抽取、优化并写出后立即释放整个上下文，再验证写出的文件。线程之间只共享只读的分析结果。
+ * 每组开始前按predictEmissionFootprint的预测占用向内存预算申请额度，
+ * 预算不足时等待其他组释放，同时运行的组数不超过线程数。
+ * 文件序号按组号顺序预先分配，与串行生成一致；组按预测占用降序领取，总耗时接近最大组的耗时。
+ *
+ * @return 成功生成的文件数
+ */
+int BCModuleSplitter::emitGroupsInParallel(llvm::StringRef outputPrefix, unsigned threadCount) {
+    const GroupTable &groupTable = common.getGroupTable();
+
+    std::vector<EmissionTask> tasks;
+    for (size_t groupId = 0; groupId < groupTable.getGroupCount(); groupId++) {
+        llvm::ArrayRef<SymbolId> members = groupTable.members(groupId);
+        if (members.empty())
+            continue;
+        int fileIndex = static_cast<int>(tasks.size());
+        std::string filename =
+            outputPrefix.str() + (fileIndex == 0 ? "_publicGroup.bc" : "_group_" + std::to_string(fileIndex) + ".bc");
+        tasks.push_back({groupId, fileIndex, std::move(filename), common.predictEmissionFootprint(members)});
+    }
+    std::stable_sort(tasks.begin(), tasks.end(), [](const EmissionTask &a, const EmissionTask &b) {
+        return a.predictedBytes > b.predictedBytes;
+    });
+
+    const size_t MB = 1024 * 1024;
+    size_t budgetBytes = config.emissionMemoryBudgetMB * MB;
+    if (budgetBytes == 0)
+        budgetBytes = MemoryBudget::getPhysicalMemory() / 4 * 3;
+    if (budgetBytes == 0)
+        budgetBytes = SIZE_MAX;
+    MemoryBudget budget(budgetBytes);
+
+    threadCount = static_cast<unsigned>(std::min<size_t>(threadCount, tasks.size()));
+    logger.log("并行生成 " + std::to_string(tasks.size()) + " 个分组BC文件, " + std::to_string(threadCount) +
+               " 个线程, 内存预算 " + (budgetBytes == SIZE_MAX ? "不限" : std::to_string(budgetBytes / MB) + " MB"));
+    if (!tasks.empty()) {
+        logger.logToFile("最大分组预计占用 " + std::to_string(tasks.front().predictedBytes / MB) + " MB");
+    }
+
+    // 每个工作线程一个优化器，分析注册和O2管道构建在每个线程上只做一次；
+    // 配置和自定义 Pass 取自主优化器，与串行生成一致
+    custom::OptimizerPool optimizers(threadCount, optimizer);
+    std::atomic<int> fileCount{0};
+    BCCommon::runInParallel(tasks.size(), threadCount, [&](size_t taskIndex, unsigned worker) {
+        const EmissionTask &task = tasks[taskIndex];
+        llvm::ArrayRef<SymbolId> members = groupTable.members(task.groupId);
+
+        budget.acquire(task.predictedBytes);
+        logger.log("处理组 {" + std::to_string(task.fileIndex) + "} 包含 " + std::to_string(members.size()) +
+                   " 个符号");
+
+        bool created = false;
+        {
+            std::unique_ptr<EmissionContext> emission = createEmissionContext();
+            created = emission && emitGroup(*emission->module, emission->symbols, optimizers.get(worker), members,
+                                            task.filename, task.fileIndex);
+            // 离开作用域即释放该组的模块和上下文
+        }
+
+        if (!created) {
+            logger.logError("✗ 创建BC文件失败: " + task.filename);
+        } else {
+            if (validateEmittedFile(task.fileIndex)) {
+                logger.log("✓ Clone模式分组BC文件验证通过: " + task.filename);
+            } else {
+                logger.logError("✗ BC文件验证失败: " + task.filename);
+            }
+            fileCount++;
+        }
+        budget.release(task.predictedBytes);
+    });
+
+    logger.logToFile("并行生成完成, 预计内存峰值 " + std::to_string(budget.getPeak() / MB) + " MB");
+    return fileCount.load();
 }
 
 // 新增：处理克隆模块中的符号
@@ -757,14 +1302,32 @@ void BCModuleSplitter::processClonedModuleGlobalValues(llvm::Module &M,
 }
 
 // 在 splitter.cpp 中添加这些方法的实现
-bool BCModuleSplitter::runOptimizationAndVerify(llvm::Module &M) {
-    // 1. 运行优化
-    if (!optimizer.runOptimization(M)) {
+bool BCModuleSplitter::runOptimizationAndVerify(llvm::Module &M) { return runOptimizationAndVerify(M, optimizer); }
+
+// 使用指定的优化器实例（并行生成时每个工作线程各有一个）和该组的优化方案
+bool BCModuleSplitter::runOptimizationAndVerify(llvm::Module &M, custom::CustomOptimizer &moduleOptimizer,
+                                                const custom::OptimizationProfile &profile,
+                                                custom::OptimizationTelemetry *telemetry) {
+    // 1. 运行优化，耗时按模块记录并累计到optimizationMicros
+    auto optimizeStart = std::chrono::steady_clock::now();
+    bool optimized = moduleOptimizer.runOptimization(M, profile, telemetry);
+    auto elapsed =
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - optimizeStart);
+    optimizationMicros += elapsed.count();
+    logger.logToFile("优化耗时 " + M.getModuleIdentifier() + " [" + profile.getName() +
+                     "]: " + std::to_string(elapsed.count() / 1000) + " ms");
+    if (!optimized) {
         logger.logToFile("✗ 运行优化失败");
         return false;
     }
 
-    // 2. 验证优化后的模块
+    // 2. 压缩：删除无引用的声明、comdat、元数据，丢弃局部名字
+    if (config.compactGroupModules) {
+        CompactionStats stats = ModuleCompactor().run(M);
+        logger.logToFile("模块压缩 " + M.getModuleIdentifier() + ": " + stats.getSummary());
+    }
+
+    // 3. 验证优化后的模块
     std::string ErrorInfo;
     llvm::raw_string_ostream OS(ErrorInfo);
     if (llvm::verifyModule(M, &OS)) {
@@ -785,7 +1348,7 @@ void BCModuleSplitter::validateAllBCFiles(llvm::StringRef outputPrefix) {
 
 // 验证并修复单个BC文件
 bool BCModuleSplitter::verifyAndFixBCFile(llvm::StringRef filename,
-                                          const llvm::DenseSet<llvm::GlobalValue *> &expectedGroup) {
+                                          llvm::ArrayRef<llvm::GlobalValue *> expectedGroup) {
     return verifier.verifyAndFixBCFile(filename, expectedGroup);
 }
 
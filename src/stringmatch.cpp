@@ -0,0 +1,192 @@
+// stringmatch.cpp
+#include "stringmatch.h"
+#include <algorithm>
+
+AhoCorasickMatcher::AhoCorasickMatcher() { clear(); }
+
+void AhoCorasickMatcher::clear() {
+    built = false;
+    stateCount = 1;
+    pendingEdges.clear();
+    edgeOffsets.clear();
+    edgeLabels.clear();
+    edgeTargets.clear();
+    failureLink.clear();
+    outputLink.clear();
+    terminalPattern.assign(1, InvalidPattern);
+    patternLengths.clear();
+}
+
+uint32_t AhoCorasickMatcher::addPattern(llvm::StringRef pattern) {
+    if (pattern.empty() || built)
+        return InvalidPattern;
+
+    uint32_t state = 0;
+    for (char ch : pattern) {
+        uint64_t key = (static_cast<uint64_t>(state) << 8) | static_cast<unsigned char>(ch);
+        auto result = pendingEdges.try_emplace(key, stateCount);
+        if (result.second) {
+            stateCount++;
+            terminalPattern.push_back(InvalidPattern);
+        }
+        state = result.first->second;
+    }
+
+    if (terminalPattern[state] == InvalidPattern) {
+        terminalPattern[state] = static_cast<uint32_t>(patternLengths.size());
+        patternLengths.push_back(static_cast<uint32_t>(pattern.size()));
+    }
+    return terminalPattern[state];
+}
+
+/**
+ * @brief 把trie转为CSR goto表，并按BFS顺序计算失败链和输出链
+ */
+void AhoCorasickMatcher::build() {
+    if (built)
+        return;
+
+    // 按 (父状态, 字符) 排序后即为CSR顺序
+    std::vector<std::pair<uint64_t, uint32_t>> edges(pendingEdges.begin(), pendingEdges.end());
+    pendingEdges.shrink_and_clear();
+    std::sort(edges.begin(), edges.end());
+
+    edgeOffsets.assign(stateCount + 1, 0);
+    edgeLabels.resize(edges.size());
+    edgeTargets.resize(edges.size());
+    for (size_t i = 0; i < edges.size(); i++) {
+        edgeOffsets[(edges[i].first >> 8) + 1]++;
+        edgeLabels[i] = static_cast<unsigned char>(edges[i].first & 0xff);
+        edgeTargets[i] = edges[i].second;
+    }
+    for (uint32_t s = 0; s < stateCount; s++) {
+        edgeOffsets[s + 1] += edgeOffsets[s];
+    }
+
+    failureLink.assign(stateCount, 0);
+    outputLink.assign(stateCount, 0);
+
+    // BFS：父状态的失败链先于子状态算出
+    std::vector<uint32_t> queue;
+    queue.reserve(stateCount);
+    for (uint32_t e = edgeOffsets[0]; e < edgeOffsets[1]; e++) {
+        queue.push_back(edgeTargets[e]);
+    }
+    for (size_t head = 0; head < queue.size(); head++) {
+        uint32_t state = queue[head];
+        for (uint32_t e = edgeOffsets[state]; e < edgeOffsets[state + 1]; e++) {
+            uint32_t target = edgeTargets[e];
+            unsigned char label = edgeLabels[e];
+
+            uint32_t fallback = failureLink[state];
+            uint32_t failure = child(fallback, label);
+            while (failure == InvalidPattern && fallback != 0) {
+                fallback = failureLink[fallback];
+                failure = child(fallback, label);
+            }
+            failureLink[target] = failure == InvalidPattern ? 0 : failure;
+
+            uint32_t f = failureLink[target];
+            outputLink[target] = terminalPattern[f] != InvalidPattern ? f : outputLink[f];
+            queue.push_back(target);
+        }
+    }
+
+    built = true;
+}
+
+uint32_t AhoCorasickMatcher::child(uint32_t state, unsigned char c) const {
+    auto begin = edgeLabels.begin() + edgeOffsets[state];
+    auto end = edgeLabels.begin() + edgeOffsets[state + 1];
+    auto it = std::lower_bound(begin, end, c);
+    if (it == end || *it != c)
+        return InvalidPattern;
+    return edgeTargets[it - edgeLabels.begin()];
+}
+
+uint32_t AhoCorasickMatcher::next(uint32_t state, unsigned char c) const {
+    while (true) {
+        uint32_t target = child(state, c);
+        if (target != InvalidPattern)
+            return target;
+        if (state == 0)
+            return 0;
+        state = failureLink[state];
+    }
+}
+
+bool AhoCorasickMatcher::containsAny(llvm::StringRef text) const {
+    if (!built || patternLengths.empty())
+        return false;
+
+    bool found = false;
+    forEachMatch(text, [&](uint32_t, size_t) {
+        found = true;
+        return false;
+    });
+    return found;
+}
+
+uint32_t AhoCorasickMatcher::findLongestMatch(llvm::StringRef text) const {
+    uint32_t best = InvalidPattern;
+    if (!built || patternLengths.empty())
+        return best;
+
+    forEachMatch(text, [&](uint32_t patternId, size_t) {
+        if (best == InvalidPattern || patternLengths[patternId] > patternLengths[best] ||
+            (patternLengths[patternId] == patternLengths[best] && patternId < best))
+            best = patternId;
+        return true;
+    });
+    return best;
+}
+
+PackageClassifier::PackageClassifier(llvm::ArrayRef<std::string> packages) {
+    // 自动机对重复包名返回同一模式编号，记录每个模式第一次出现的包下标
+    for (size_t i = 0; i < packages.size(); i++) {
+        uint32_t patternId = matcher.addPattern(packages[i]);
+        if (patternId != AhoCorasickMatcher::InvalidPattern && patternId == patternToPackage.size())
+            patternToPackage.push_back(static_cast<int>(i));
+    }
+    matcher.build();
+}
+
+std::vector<int> PackageClassifier::classify(llvm::ArrayRef<llvm::StringRef> names) const {
+    std::vector<int> packageOf(names.size(), Unclassified);
+    if (names.empty())
+        return packageOf;
+
+    std::string nameBuffer;
+    size_t totalLength = 0;
+    for (llvm::StringRef name : names) {
+        totalLength += name.size() + 1;
+    }
+    nameBuffer.reserve(totalLength);
+    for (llvm::StringRef name : names) {
+        nameBuffer += name;
+        nameBuffer += '\0';
+    }
+
+    // 顺序扫描，遇到分隔符时结算当前名字
+    std::vector<uint32_t> bestPattern(names.size(), AhoCorasickMatcher::InvalidPattern);
+    size_t current = 0;
+    size_t currentEnd = names[0].size();
+    matcher.forEachMatch(nameBuffer, [&](uint32_t patternId, size_t endOffset) {
+        while (endOffset > currentEnd) {
+            current++;
+            currentEnd += 1 + names[current].size();
+        }
+        uint32_t &best = bestPattern[current];
+        if (best == AhoCorasickMatcher::InvalidPattern ||
+            matcher.getPatternLength(patternId) > matcher.getPatternLength(best) ||
+            (matcher.getPatternLength(patternId) == matcher.getPatternLength(best) && patternId < best))
+            best = patternId;
+        return true;
+    });
+
+    for (size_t i = 0; i < names.size(); i++) {
+        if (bestPattern[i] != AhoCorasickMatcher::InvalidPattern)
+            packageOf[i] = patternToPackage[bestPattern[i]];
+    }
+    return packageOf;
+}
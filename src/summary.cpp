@@ -0,0 +1,87 @@
+// summary.cpp
+#include "summary.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Analysis/ModuleSummaryAnalysis.h"
+#include "llvm/Analysis/ProfileSummaryInfo.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include <algorithm>
+
+std::unique_ptr<llvm::ModuleSummaryIndex> SummaryCallGraphSource::readEmbeddedIndex(llvm::MemoryBufferRef buffer,
+                                                                                    std::string &error) {
+    llvm::Expected<llvm::BitcodeLTOInfo> infoOrErr = llvm::getBitcodeLTOInfo(buffer);
+    if (!infoOrErr) {
+        error = llvm::toString(infoOrErr.takeError());
+        return nullptr;
+    }
+    if (!infoOrErr->HasSummary)
+        return nullptr;
+
+    llvm::Expected<std::unique_ptr<llvm::ModuleSummaryIndex>> indexOrErr = llvm::getModuleSummaryIndex(buffer);
+    if (!indexOrErr) {
+        error = llvm::toString(indexOrErr.takeError());
+        return nullptr;
+    }
+    return std::move(indexOrErr.get());
+}
+
+std::unique_ptr<llvm::ModuleSummaryIndex> SummaryCallGraphSource::buildIndex(const llvm::Module &M) {
+    // 没有BFI回调时，带profile数据的函数由ModuleSummaryAnalysis自行计算块频率
+    llvm::ProfileSummaryInfo PSI(M);
+    return std::make_unique<llvm::ModuleSummaryIndex>(llvm::buildModuleSummaryIndex(M, nullptr, &PSI));
+}
+
+SummaryEdgeStats SummaryCallGraphSource::collectEdges(const llvm::ModuleSummaryIndex &index,
+                                                      llvm::ArrayRef<llvm::GlobalValue *> symbols,
+                                                      std::vector<CallGraph::Edge> &edges,
+                                                      std::vector<uint32_t> &instructionCounts) {
+    SummaryEdgeStats stats;
+    llvm::DenseMap<llvm::GlobalValue::GUID, SymbolId> idOfGUID;
+    idOfGUID.reserve(symbols.size());
+    for (SymbolId id = 0; id < symbols.size(); id++) {
+        idOfGUID.try_emplace(symbols[id]->getGUID(), id);
+    }
+    auto lookup = [&](const llvm::ValueInfo &VI) {
+        auto it = idOfGUID.find(VI.getGUID());
+        return it == idOfGUID.end() ? InvalidSymbolId : it->second;
+    };
+    // 与IR分析一致：只记录两端都是符号的非自环边
+    auto addEdge = [&](SymbolId from, SymbolId to) {
+        if (to == InvalidSymbolId || from == to)
+            return false;
+        edges.emplace_back(from, to);
+        return true;
+    };
+
+    for (SymbolId id = 0; id < symbols.size(); id++) {
+        const llvm::GlobalValue *GV = symbols[id];
+        if (GV->isDeclaration() && !GV->isMaterializable())
+            continue;
+
+        llvm::ValueInfo VI = index.getValueInfo(GV->getGUID());
+        if (!VI || VI.getSummaryList().empty()) {
+            stats.missingSummaries++;
+            continue;
+        }
+
+        for (const std::unique_ptr<llvm::GlobalValueSummary> &summary : VI.getSummaryList()) {
+            for (const llvm::ValueInfo &ref : summary->refs()) {
+                if (addEdge(id, lookup(ref)))
+                    stats.refEdges++;
+            }
+
+            const auto *FS = llvm::dyn_cast<llvm::FunctionSummary>(summary.get());
+            if (!FS)
+                continue;
+            instructionCounts[id] = std::max(instructionCounts[id], FS->instCount());
+            for (const llvm::FunctionSummary::EdgeTy &call : FS->calls()) {
+                if (!addEdge(id, lookup(call.first)))
+                    continue;
+                stats.callEdges++;
+                if (call.second.getHotness() == llvm::CalleeInfo::HotnessType::Hot ||
+                    call.second.getHotness() == llvm::CalleeInfo::HotnessType::Critical)
+                    stats.hotCallEdges++;
+            }
+        }
+    }
+    return stats;
+}
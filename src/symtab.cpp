@@ -0,0 +1,51 @@
+// symtab.cpp
+#include "symtab.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Object/IRSymtab.h"
+
+bool PreliminaryPlan::build(llvm::MemoryBufferRef buffer, const PackageClassifier &classifier, size_t packageCount,
+                            PreliminaryPlan &plan, std::string &error) {
+    plan = PreliminaryPlan();
+
+    llvm::Expected<llvm::BitcodeFileContents> contentsOrErr = llvm::getBitcodeFileContents(buffer);
+    if (!contentsOrErr) {
+        error = llvm::toString(contentsOrErr.takeError());
+        return false;
+    }
+    llvm::Expected<llvm::irsymtab::FileContents> symtabOrErr = llvm::irsymtab::readBitcode(*contentsOrErr);
+    if (!symtabOrErr) {
+        error = llvm::toString(symtabOrErr.takeError());
+        return false;
+    }
+    const llvm::irsymtab::Reader &reader = symtabOrErr->TheReader;
+    plan.moduleCount = reader.getNumModules();
+
+    // 只取有IR名字的定义；模块内联汇编中的符号没有IR名字
+    std::vector<llvm::StringRef> names;
+    std::vector<bool> isFunction;
+    for (const llvm::irsymtab::Reader::SymbolRef &symbol : reader.symbols()) {
+        if (symbol.isUndefined()) {
+            plan.undefinedSymbols++;
+            continue;
+        }
+        if (symbol.getIRName().empty())
+            continue;
+        names.push_back(symbol.getIRName());
+        isFunction.push_back(symbol.isExecutable());
+    }
+    plan.definedSymbols = names.size();
+
+    plan.packageSeeds.assign(packageCount, 0);
+    plan.packageFunctions.assign(packageCount, 0);
+    std::vector<int> packageOf = classifier.classify(names);
+    for (size_t i = 0; i < names.size(); i++) {
+        if (packageOf[i] == PackageClassifier::Unclassified) {
+            plan.unclassified++;
+            continue;
+        }
+        plan.packageSeeds[packageOf[i]]++;
+        if (isFunction[i])
+            plan.packageFunctions[packageOf[i]]++;
+    }
+    return true;
+}
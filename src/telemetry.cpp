@@ -0,0 +1,146 @@
+// telemetry.cpp
+#include "telemetry.h"
+#include "llvm/ADT/Any.h"
+#include <algorithm>
+#include <time.h>
+
+namespace custom {
+
+// Pass管理器和适配器只是转发，计时交给其中真正的Pass
+static bool isContainerPass(llvm::StringRef PassID) {
+    static const std::vector<llvm::StringRef> Containers = {
+        "PassManager", "PassAdaptor", "AnalysisManagerProxy", "ModuleInlinerWrapperPass", "DevirtSCCRepeatedPass",
+        "CustomPassAdapter"};
+    return llvm::isSpecialPass(PassID, Containers);
+}
+
+void PassTimingRecorder::registerCallbacks(llvm::PassInstrumentationCallbacks &PIC) {
+    PIC.registerBeforeNonSkippedPassCallback([this](llvm::StringRef PassID, llvm::Any) {
+        if (Active && !isContainerPass(PassID))
+            push(PassID, false);
+    });
+    PIC.registerAfterPassCallback([this](llvm::StringRef PassID, llvm::Any IR, const llvm::PreservedAnalyses &) {
+        if (!Active || isContainerPass(PassID))
+            return;
+        pop();
+        // 模块级Pass结束时采样指令数，函数级Pass数量太多，不逐个采样
+        if (const auto *M = llvm::any_cast<const llvm::Module *>(&IR))
+            sampleInstructions(**M);
+    });
+    PIC.registerAfterPassInvalidatedCallback([this](llvm::StringRef PassID, const llvm::PreservedAnalyses &) {
+        if (Active && !isContainerPass(PassID))
+            pop();
+    });
+    PIC.registerBeforeAnalysisCallback([this](llvm::StringRef PassID, llvm::Any) {
+        if (Active && !isContainerPass(PassID))
+            push(PassID, true);
+    });
+    PIC.registerAfterAnalysisCallback([this](llvm::StringRef PassID, llvm::Any) {
+        if (Active && !isContainerPass(PassID))
+            pop();
+    });
+}
+
+void PassTimingRecorder::start(const llvm::Module &M, OptimizationTelemetry &Telemetry) {
+    Active = &Telemetry;
+    PassIndex.clear();
+    AnalysisIndex.clear();
+    Stack.clear();
+    Telemetry.Passes.clear();
+    Telemetry.InstructionsBefore = countInstructions(M);
+    Telemetry.PeakInstructions = Telemetry.InstructionsBefore;
+    StartWall = std::chrono::steady_clock::now();
+    StartCpuMs = getThreadCpuMs();
+}
+
+void PassTimingRecorder::finish(const llvm::Module &M) {
+    if (!Active)
+        return;
+    // 异常中断时栈中可能还有未结束的Pass
+    while (!Stack.empty())
+        pop();
+
+    Active->WallMs =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - StartWall).count();
+    Active->CpuMs = getThreadCpuMs() - StartCpuMs;
+    Active->InstructionsAfter = countInstructions(M);
+    Active->PeakInstructions = std::max(Active->PeakInstructions, Active->InstructionsAfter);
+    std::stable_sort(Active->Passes.begin(), Active->Passes.end(),
+                     [](const PassTiming &A, const PassTiming &B) { return A.WallMs > B.WallMs; });
+    Active = nullptr;
+}
+
+void PassTimingRecorder::enterCustomPass(llvm::StringRef Name) {
+    if (Active)
+        push(Name, false);
+}
+
+void PassTimingRecorder::leaveCustomPass(const llvm::Module &M) {
+    if (!Active)
+        return;
+    pop();
+    sampleInstructions(M);
+}
+
+uint64_t PassTimingRecorder::countInstructions(const llvm::Module &M) {
+    uint64_t Count = 0;
+    for (const llvm::Function &F : M) {
+        Count += F.getInstructionCount();
+    }
+    return Count;
+}
+
+void PassTimingRecorder::push(llvm::StringRef PassID, bool IsAnalysis) {
+    auto Now = std::chrono::steady_clock::now();
+    double CpuNow = getThreadCpuMs();
+    // 暂停外层的计时
+    if (!Stack.empty()) {
+        Frame &Outer = Stack.back();
+        PassTiming &Entry = Active->Passes[Outer.Entry];
+        Entry.WallMs += std::chrono::duration<double, std::milli>(Now - Outer.Wall).count();
+        Entry.CpuMs += CpuNow - Outer.CpuMs;
+    }
+
+    llvm::StringMap<size_t> &Index = IsAnalysis ? AnalysisIndex : PassIndex;
+    auto Inserted = Index.try_emplace(PassID, Active->Passes.size());
+    if (Inserted.second) {
+        PassTiming Entry;
+        Entry.Name = PassID.str();
+        Entry.IsAnalysis = IsAnalysis;
+        Active->Passes.push_back(std::move(Entry));
+    }
+    size_t Slot = Inserted.first->second;
+    Active->Passes[Slot].Runs++;
+    Stack.push_back({Slot, Now, CpuNow});
+}
+
+void PassTimingRecorder::pop() {
+    if (Stack.empty())
+        return;
+    auto Now = std::chrono::steady_clock::now();
+    double CpuNow = getThreadCpuMs();
+    Frame Inner = Stack.back();
+    Stack.pop_back();
+    PassTiming &Entry = Active->Passes[Inner.Entry];
+    Entry.WallMs += std::chrono::duration<double, std::milli>(Now - Inner.Wall).count();
+    Entry.CpuMs += CpuNow - Inner.CpuMs;
+
+    // 恢复外层的计时
+    if (!Stack.empty()) {
+        Stack.back().Wall = Now;
+        Stack.back().CpuMs = CpuNow;
+    }
+}
+
+void PassTimingRecorder::sampleInstructions(const llvm::Module &M) {
+    Active->PeakInstructions = std::max(Active->PeakInstructions, countInstructions(M));
+}
+
+double PassTimingRecorder::getThreadCpuMs() {
+    timespec Time;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &Time) != 0)
+        return 0;
+    return Time.tv_sec * 1000.0 + Time.tv_nsec / 1e6;
+}
+
+} // namespace custom
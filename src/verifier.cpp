@@ -75,7 +75,7 @@ std::string BCVerifier::getVisibilityString(llvm::GlobalValue::VisibilityTypes v
 }
 
 // 新增：带独立日志的构建符号名映射方法
-void BCVerifier::buildGlobalValueNameMapsWithLog(const llvm::DenseSet<llvm::GlobalValue *> &group,
+void BCVerifier::buildGlobalValueNameMapsWithLog(llvm::ArrayRef<llvm::GlobalValue *> group,
                                                  llvm::StringMap<llvm::GlobalValue *> &nameToGV,
                                                  llvm::StringMap<std::string> &escapedToOriginal,
                                                  std::ofstream &individualLog) {
@@ -181,7 +181,7 @@ bool BCVerifier::quickValidateBCFileWithLog(llvm::StringRef filename, std::ofstr
 // 完整的带独立日志的分析验证错误方法
 // 修改 analyzeVerifierErrorsWithLog 符号中的映射构建部分
 llvm::StringSet<> BCVerifier::analyzeVerifierErrorsWithLog(llvm::StringRef verifyOutput,
-                                                           const llvm::DenseSet<llvm::GlobalValue *> &group,
+                                                           llvm::ArrayRef<llvm::GlobalValue *> group,
                                                            std::ofstream &individualLog) {
     llvm::StringSet<> globalValuesNeedExternal;
 
@@ -460,7 +460,7 @@ llvm::StringSet<> BCVerifier::analyzeVerifierErrorsWithLog(llvm::StringRef verif
 // 新增：验证并修复BC文件的方法
 // 添加独立日志支持
 bool BCVerifier::verifyAndFixBCFile(llvm::StringRef filename,
-                                    const llvm::DenseSet<llvm::GlobalValue *> &expectedGroup) {
+                                    llvm::ArrayRef<llvm::GlobalValue *> expectedGroup) {
     // 创建独立日志文件
     std::ofstream individualLog = logger.createIndividualLogFile(filename, "_verify");
 
@@ -610,33 +610,30 @@ void BCVerifier::validateAllBCFiles(llvm::StringRef outputPrefix, bool isCloneMo
 
     int totalFiles = 0;
     int validFiles = 0;
-    auto &globalValuesAllGroups = common.getGlobalValuesAllGroups();
     std::string pathPrefix = config.workSpace + "output/";
 
-    // 检查
-    for (int i = 0; i < globalValuesAllGroups.size(); i++) {
-        if (globalValuesAllGroups[i].empty())
-            continue;
-
-        std::string filename =
-            outputPrefix.str() + (totalFiles == 0 ? "_publicGroup.bc" : "_group_" + std::to_string(totalFiles) + ".bc");
-
-        if (!llvm::sys::fs::exists(pathPrefix + filename)) {
+    // 检查：默认使用生成时在内存中的验证结果，paranoidReparse时重新解析每个文件
+    for (const EmissionRecord &record : common.getEmissionRecords()) {
+        if (!record.written || !llvm::sys::fs::exists(pathPrefix + record.filename)) {
             continue;
         }
+        const std::string &filename = record.filename;
 
         totalFiles++;
         std::ofstream individualLog = logger.createIndividualLogFile(filename, "_validation");
 
         if (isCloneMode) {
-            if (quickValidateBCFile(filename)) {
+            bool valid = config.paranoidReparse ? quickValidateBCFile(filename) : record.moduleValid;
+            if (valid) {
                 logger.logToIndividualLog(individualLog, "✓ Clone模式验证通过", true);
                 validFiles++;
             } else {
                 logger.logToIndividualLog(individualLog, "✗ Clone模式验证失败", true);
             }
         } else {
-            if (quickValidateBCFileWithLog(filename, individualLog)) {
+            bool valid =
+                config.paranoidReparse ? quickValidateBCFileWithLog(filename, individualLog) : record.moduleValid;
+            if (valid) {
                 logger.logToIndividualLog(individualLog, "✓ 快速验证通过", true);
                 validFiles++;
             } else {
@@ -722,7 +719,7 @@ void BCVerifier::analyzeBCFileContent(llvm::StringRef filename) {
 }
 
 // 修改后的重新生成BC文件方法，使用专门的无名符号修复
-bool BCVerifier::recreateBCFileWithExternalLinkage(const llvm::DenseSet<llvm::GlobalValue *> &group,
+bool BCVerifier::recreateBCFileWithExternalLinkage(llvm::ArrayRef<llvm::GlobalValue *> group,
                                                    const llvm::StringSet<> &externalGVNames, llvm::StringRef filename,
                                                    int groupIndex) {
     logger.logToFile("重新生成BC文件: " + filename.str() + " (应用external链接)");
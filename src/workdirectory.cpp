@@ -27,7 +27,11 @@ bool BCWorkDir::createWorkDirectoryStructure() {
     std::string workDir = config.workSpace;
     if (std::filesystem::exists(workDir) && std::filesystem::is_directory(workDir)) {
         std::cout << "有历史记录,需要清理... " << std::endl;
-        std::filesystem::remove_all(workDir);
+        // 分析缓存和配置文件跨运行保留，其余内容全部清理
+        for (const auto &entry : std::filesystem::directory_iterator(workDir)) {
+            if (entry.path().filename() != "cache" && entry.path().filename() != "config")
+                std::filesystem::remove_all(entry.path());
+        }
     }
 
     std::cout << "创建BCSplitter工作目录结构..." << std::endl;
@@ -38,7 +42,7 @@ bool BCWorkDir::createWorkDirectoryStructure() {
     }
 
     // 子目录列表
-    std::vector<std::string> subDirs = {"input", "output", "temp", "logs", "config"};
+    std::vector<std::string> subDirs = {"input", "output", "temp", "logs", "config", "cache"};
 
     // 创建子目录
     for (const auto &dir : subDirs) {
@@ -0,0 +1,105 @@
+// writer.cpp
+#include "writer.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+
+AsyncFileWriter::AsyncFileWriter(size_t maxQueuedBytes) : maxQueued(maxQueuedBytes) {
+    worker = std::thread(&AsyncFileWriter::run, this);
+}
+
+AsyncFileWriter::~AsyncFileWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    jobReady.notify_all();
+    if (worker.joinable())
+        worker.join();
+}
+
+// 单个缓冲区超过上限时只在队列为空时放行，与MemoryBudget的规则一致
+void AsyncFileWriter::submit(std::string path, llvm::SmallVector<char, 0> data, Completion onComplete) {
+    size_t bytes = data.size();
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        spaceFreed.wait(lock, [&]() { return queuedBytes == 0 || queuedBytes + bytes <= maxQueued; });
+        queuedBytes += bytes;
+        peakQueued = std::max(peakQueued, queuedBytes);
+        jobs.push_back({std::move(path), std::move(data), std::move(onComplete)});
+    }
+    jobReady.notify_one();
+}
+
+void AsyncFileWriter::drain() {
+    std::unique_lock<std::mutex> lock(mutex);
+    spaceFreed.wait(lock, [&]() { return jobs.empty() && inFlight == 0; });
+}
+
+size_t AsyncFileWriter::getPeakQueuedBytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return peakQueued;
+}
+
+// 析构时先写完队列中剩余的任务再退出
+void AsyncFileWriter::run() {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            jobReady.wait(lock, [&]() { return stopping || !jobs.empty(); });
+            if (jobs.empty())
+                return;
+            job = std::move(jobs.front());
+            jobs.pop_front();
+            inFlight++;
+        }
+
+        std::string error;
+        bool ok = writeAtomically(job.path, job.data, error);
+        if (ok) {
+            logger.log("✓ 成功写入: " + llvm::sys::path::filename(job.path).str());
+        } else {
+            logger.logError("写入失败: " + job.path + " - " + error);
+        }
+        if (job.onComplete)
+            job.onComplete(ok);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queuedBytes -= std::min(job.data.size(), queuedBytes);
+            inFlight--;
+        }
+        spaceFreed.notify_all();
+    }
+}
+
+bool AsyncFileWriter::writeAtomically(llvm::StringRef path, llvm::ArrayRef<char> data, std::string &error) {
+    // 临时文件放在目标同目录，保证rename不跨文件系统
+    int fd = -1;
+    llvm::SmallString<256> tempPath;
+    if (std::error_code ec = llvm::sys::fs::createUniqueFile(path + ".%%%%%%.tmp", fd, tempPath)) {
+        error = "无法创建临时文件: " + ec.message();
+        return false;
+    }
+
+    {
+        llvm::raw_fd_ostream out(fd, /*shouldClose=*/true);
+        out.write(data.data(), data.size());
+        out.close();
+        if (out.has_error()) {
+            error = "写入临时文件失败: " + out.error().message();
+            out.clear_error();
+            llvm::sys::fs::remove(tempPath);
+            return false;
+        }
+    }
+
+    if (std::error_code ec = llvm::sys::fs::rename(tempPath, path)) {
+        error = "重命名临时文件失败: " + ec.message();
+        llvm::sys::fs::remove(tempPath);
+        return false;
+    }
+    return true;
+}